@@ -22,6 +22,8 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+
 #include "Algorithm.hpp"
 
 Algorithm::Algorithm() {
@@ -40,6 +42,8 @@ Algorithm::Algorithm(const Algorithm& obj) {
     algorithm = obj.algorithm;
     algorithmNumber = obj.algorithmNumber;
     algorithmOrder = obj.algorithmOrder;
+    layerDepth = obj.layerDepth;
+    algorithmBase = obj.algorithmBase;
 }
 
 Algorithm::Algorithm(const char* algorithm) {
@@ -51,6 +55,8 @@ Algorithm& Algorithm::operator=(const Algorithm& rhs) {
         algorithm = rhs.algorithm;
         algorithmNumber = rhs.algorithmNumber;
         algorithmOrder = rhs.algorithmOrder;
+        layerDepth = rhs.layerDepth;
+        algorithmBase = rhs.algorithmBase;
     }
     return *this;
 }
@@ -129,6 +135,37 @@ unsigned int Algorithm::getAlgorithmOrder() const {
     return algorithmOrder;
 }
 
+void Algorithm::setLayerDepth(unsigned int layerDepth) {
+    if (layerDepth < 1)
+        layerDepth = 1;
+    if (layerDepth == this->layerDepth)
+        return;
+
+    std::vector<Turn> turns;
+    for (unsigned long long int t : algorithm)
+        turns.push_back(getTurnForNumber(t));
+
+    this->layerDepth = layerDepth;
+    algorithmBase = getAlgorithmBase(layerDepth);
+    for (size_t i = 0; i < turns.size(); i++)
+        algorithm.at(i) = getNumberForTurn(turns.at(i));
+    updateAlgorithmNumber();
+}
+
+unsigned int Algorithm::getLayerDepth() const {
+    return layerDepth;
+}
+
+unsigned int Algorithm::getAlgorithmBase() const {
+    return algorithmBase;
+}
+
+unsigned int Algorithm::getAlgorithmBase(unsigned int layerDepth) {
+    if (layerDepth < 1)
+        layerDepth = 1;
+    return ALGORITHM_BASE*(2*layerDepth - 1);
+}
+
 void Algorithm::incrementAlgorithmToAlgNum(unsigned long long int algNum) {
     if (algNum == algorithmNumber)
         return;
@@ -144,23 +181,43 @@ bool Algorithm::isValid(const char* algorithm) {
         return false;
     
     bool inTurn = false;
-    Layer layer;
+    bool hasTurn = false;
+    bool hasPrefix = false;
+    bool hasSuffix = false;
+    Layer layer = Layer::NOLAYER;
 
     while (*algorithm != '\0') {
-        layer = Algorithm::charToLayer(*algorithm);
         if (inTurn) {
-            if (*algorithm != ' ' && *algorithm != '\'')
-                return false;
-            if (*algorithm == ' ')
+            if (*algorithm == 'w' && !hasSuffix) {
+                if (layer == Layer::M || layer == Layer::E || layer == Layer::S)
+                    return false;
+                hasSuffix = true;
+            } else if (*algorithm == '\'') {
+                hasSuffix = true;
+            } else if (*algorithm == ' ') {
                 inTurn = false;
-        } else if (layer != Layer::NOLAYER) {
-            inTurn = true;
+                hasPrefix = false;
+                hasSuffix = false;
+            } else {
+                return false;
+            }
+        } else if (*algorithm >= '0' && *algorithm <= '9') {
+            if (!hasPrefix && *algorithm == '0')
+                return false;
+            hasPrefix = true;
         } else {
-            return false;
+            layer = Algorithm::charToLayer(*algorithm);
+            if (layer == Layer::NOLAYER)
+                return false;
+            if (hasPrefix &&
+                (layer == Layer::M || layer == Layer::E || layer == Layer::S))
+                return false;
+            inTurn = true;
+            hasTurn = true;
         }
         algorithm++;
     }
-    return true;
+    return hasTurn && (!hasPrefix || inTurn);
 }
 
 void Algorithm::setAlgorithm(const std::vector<Turn> turns) {
@@ -170,35 +227,51 @@ void Algorithm::setAlgorithm(const std::vector<Turn> turns) {
         addTurn(turn);
 }
 
+/**
+ * Turns are appended MST first and reversed once at the end, and the number is
+ * computed once, so parsing into an existing Algorithm does not allocate
+ * unless the algorithm is longer than any it has held before. The layer depth
+ * starts over at one, so the number does not depend on what was held before.
+ */
 void Algorithm::setAlgorithm(const char *algorithm) {
     if (!isValid(algorithm))
         return;
     
     this->algorithm.clear();
-    Turn *turn = nullptr;
-    Layer layer;
+    layerDepth = 1;
+    algorithmBase = getAlgorithmBase(layerDepth);
+    Turn turn;
+    bool inTurn = false;
+    unsigned int layerNumber = 0;
 
     while (*algorithm != '\0') {
-        layer = Algorithm::charToLayer(*algorithm);
-        if (turn != nullptr) {
+        if (inTurn) {
             if (*algorithm == ' ') {
-                addTurn(*turn);
-                turn = nullptr;
+                appendTurn(turn);
+                inTurn = false;
+                layerNumber = 0;
+            } else if (*algorithm == 'w') {
+                turn.wide = true;
+                if (layerNumber == 0)
+                    turn.depth = 1;
             } else if (*algorithm == '\'') {
-                turn->clockwise = false;
-                addTurn(*turn);
-                turn = nullptr;
+                turn.clockwise = false;
             }
-        } else if (layer != Layer::NOLAYER) {
-            turn = new Turn;
-            turn->clockwise = true;
-            turn->layer = layer;
+        } else if (*algorithm >= '0' && *algorithm <= '9') {
+            layerNumber = layerNumber*10 + (unsigned int)(*algorithm - '0');
+        } else {
+            turn = {Algorithm::charToLayer(*algorithm), true};
+            if (layerNumber > 0)
+                turn.depth = layerNumber - 1;
+            inTurn = true;
         }
         algorithm++;
     }
    
-    if (turn != nullptr)
-        addTurn(*turn);
+    if (inTurn)
+        appendTurn(turn);
+    std::reverse(this->algorithm.begin(), this->algorithm.end());
+    updateAlgorithmNumber();
 }
 
 void Algorithm::reset() {
@@ -208,15 +281,36 @@ void Algorithm::reset() {
 }
 
 void Algorithm::addTurn(Turn turn) {
+    if (turn.depth >= layerDepth)
+        setLayerDepth(turn.depth + 1);
+
     std::vector<unsigned long long int>::iterator it = algorithm.begin();
     algorithm.insert(it, getNumberForTurn(turn));
+    updateAlgorithmNumber();
+}
 
+/* Adds a most significant turn without updating the algorithm number. */
+void Algorithm::appendTurn(Turn turn) {
+    if (turn.depth >= layerDepth)
+        setLayerDepth(turn.depth + 1);
+    algorithm.push_back(getNumberForTurn(turn));
+}
+
+/**
+ * Each field counts from one in a sequence (see "Algorithm Representation"),
+ * so this is the number of algorithms that come before this one, which is
+ * what addToAlgorithm keeps track of. An empty algorithm is numbered 0.
+ */
+void Algorithm::updateAlgorithmNumber() {
     algorithmNumber = 0;
+    if (algorithm.empty())
+        return;
     unsigned long long int base = 1;
     for (unsigned long long int t : algorithm) {
-        algorithmNumber += t*base;
-        base *= ALGORITHM_BASE;
+        algorithmNumber += (t + 1)*base;
+        base *= algorithmBase;
     }
+    --algorithmNumber;
 }
 
 void Algorithm::addToAlgorithm(unsigned long long int addend) {
@@ -237,12 +331,12 @@ void Algorithm::addToAlgorithm(unsigned long long int addend) {
                 fieldCarry--;
         }
 
-        addendModulus = addend % ALGORITHM_BASE;
-        addend = (addend - addendModulus) / ALGORITHM_BASE;
+        addendModulus = addend % algorithmBase;
+        addend = (addend - addendModulus) / algorithmBase;
 
         fieldSum = algorithm.at(index) + addendModulus + fieldCarry;
-        fieldValue = fieldSum % ALGORITHM_BASE;
-        fieldCarry = (fieldSum - fieldValue) / ALGORITHM_BASE;
+        fieldValue = fieldSum % algorithmBase;
+        fieldCarry = (fieldSum - fieldValue) / algorithmBase;
 
         algorithm.at(index++) = fieldValue;
     }
@@ -251,11 +345,7 @@ void Algorithm::addToAlgorithm(unsigned long long int addend) {
 std::string Algorithm::getAlgorithmStr() const {
     std::string result = "";
     for (size_t i=algorithm.size(); i > 0; i--) {
-        Turn t = getTurnForNumber(algorithm[i-1]);
-        result += layerToChar(t.layer);
-
-        if (!t.clockwise)
-            result += "\'";
+        result += turnToStr(getTurnForNumber(algorithm[i-1]));
         if (i > 1)
             result += " ";
     }
@@ -305,10 +395,7 @@ bool Algorithm::hasHiddenInversion() {
 
     /* X (Y | Y') X' */
     for (unsigned int i = 0; i < algorithm.size() - 2; i++) {
-        unsigned int o1 = getOppositeFace(algorithm.at(i));
-        unsigned int o2 = o1 + 1;
-
-        if (algorithm.at(i+1) != o1 && algorithm.at(i+1) != o2)
+        if (!isParallel(algorithm.at(i), algorithm.at(i+1)))
             continue;
 
         if (algorithm.at(i) % 2 == 0 &&
@@ -325,11 +412,8 @@ bool Algorithm::hasHiddenInversion() {
     
     /* X (Y | Y') (Y | Y') X' */
     for (unsigned int i = 0; i < algorithm.size() - 3; i++) {
-        unsigned int o1 = getOppositeFace(algorithm.at(i));
-        unsigned int o2 = o1 + 1;
-
-        if ((algorithm.at(i+1) != o1 && algorithm.at(i+1) != o2) ||
-            (algorithm.at(i+2) != o1 && algorithm.at(i+2) != o2))
+        if (!isParallel(algorithm.at(i), algorithm.at(i+1)) ||
+            !isParallel(algorithm.at(i), algorithm.at(i+2)))
             continue;
         
         if (algorithm.at(i) % 2 == 0 &&
@@ -363,22 +447,20 @@ bool Algorithm::hasHiddenTriple() {
 
     for (unsigned int i = 0; i <= (algorithm.size() - 4); i++) {
         unsigned long long int c = algorithm.at(i);
-        unsigned long long int o1 = getOppositeFace(algorithm.at(i));
-        unsigned long long int o2 = o1 + 1;
 
         if (c != algorithm.at(i+3))
             continue;
         
         /* 0:1 - X X (Y | Y') X */
         if (c == algorithm.at(i+1)) {
-            if (o1 != algorithm.at(i+2) && o2 != algorithm.at(i+2))
+            if (!isParallel(c, algorithm.at(i+2)))
                 continue;
             return true;
         }
         
         /* 1:0 - X (Y | Y') X X */
         if (c == algorithm.at(i+2)) {
-            if (o1 != algorithm.at(i+1) && o2 != algorithm.at(i+1))
+            if (!isParallel(c, algorithm.at(i+1)))
                 continue;
             return true;
         }
@@ -388,8 +470,6 @@ bool Algorithm::hasHiddenTriple() {
         return false;
     
     for (unsigned int i = 0; i <= (algorithm.size() - 5); i++) {
-        unsigned long long int o1 = getOppositeFace(algorithm.at(i));
-        unsigned long long int o2 = o1 + 1;
         unsigned long long int c = algorithm.at(i);
 
         if (c != algorithm.at(i+4))
@@ -397,27 +477,27 @@ bool Algorithm::hasHiddenTriple() {
         
         /* 0:2 - X X (Y | Y') (Y | Y') X */
         if (c == algorithm.at(i+1)) {
-            if (o1 != algorithm.at(i+2) && o2 != algorithm.at(i+2))
+            if (!isParallel(c, algorithm.at(i+2)))
                 continue;
-            if (o1 != algorithm.at(i+3) && o2 != algorithm.at(i+3))
+            if (!isParallel(c, algorithm.at(i+3)))
                 continue;
             return true;
         }
 
         /* 1:1 - X (Y | Y') X (Y | Y') X */
         if (c == algorithm.at(i+2)) {
-            if (o1 != algorithm.at(i+1) && o2 != algorithm.at(i+1))
+            if (!isParallel(c, algorithm.at(i+1)))
                 continue;
-            if (o1 != algorithm.at(i+3) && o2 != algorithm.at(i+3))
+            if (!isParallel(c, algorithm.at(i+3)))
                 continue;
             return true;
         }
 
         /* 2:0 - X (Y | Y') (Y | Y') X X */
         if (c == algorithm.at(i+3)) {
-            if (o1 != algorithm.at(i+1) && o2 != algorithm.at(i+1))
+            if (!isParallel(c, algorithm.at(i+1)))
                 continue;
-            if (o1 != algorithm.at(i+2) && o2 != algorithm.at(i+2))
+            if (!isParallel(c, algorithm.at(i+2)))
                 continue;
             return true;
         }
@@ -427,8 +507,6 @@ bool Algorithm::hasHiddenTriple() {
         return false;
     
     for (unsigned int i = 0; i <= (algorithm.size() - 6); i++) {
-        unsigned long long int o1 = getOppositeFace(algorithm.at(i));
-        unsigned long long int o2 = o1 + 1;
         unsigned long long int c = algorithm.at(i);
 
         if (c != algorithm.at(i+5))
@@ -436,22 +514,22 @@ bool Algorithm::hasHiddenTriple() {
 
         /* 1:2 - X (Y | Y') X (Y | Y') (Y | Y') X */
         if (c == algorithm.at(i+2)) {
-            if (o1 != algorithm.at(i+1) && o2 != algorithm.at(i+1))
+            if (!isParallel(c, algorithm.at(i+1)))
                 continue;
-            if (o1 != algorithm.at(i+3) && o2 != algorithm.at(i+3))
+            if (!isParallel(c, algorithm.at(i+3)))
                 continue;
-            if (o1 != algorithm.at(i+4) && o2 != algorithm.at(i+4))
+            if (!isParallel(c, algorithm.at(i+4)))
                 continue;
             return true;
         }
 
         /* 2:1 - X (Y | Y') (Y | Y') X (Y | Y') X */
         if (c == algorithm.at(i+3)) {
-            if (o1 != algorithm.at(i+1) && o2 != algorithm.at(i+1))
+            if (!isParallel(c, algorithm.at(i+1)))
                 continue;
-            if (o1 != algorithm.at(i+2) && o2 != algorithm.at(i+2))
+            if (!isParallel(c, algorithm.at(i+2)))
                 continue;
-            if (o1 != algorithm.at(i+4) && o2 != algorithm.at(i+4))
+            if (!isParallel(c, algorithm.at(i+4)))
                 continue;
             return true;
         }
@@ -461,8 +539,6 @@ bool Algorithm::hasHiddenTriple() {
         return false;
     
     for (unsigned int i = 0; i <= (algorithm.size() - 7); i++) {
-        unsigned long long int o1 = getOppositeFace(algorithm.at(i));
-        unsigned long long int o2 = o1 + 1;
         unsigned long long int c = algorithm.at(i);
 
         if (c != algorithm.at(i+6))
@@ -470,13 +546,13 @@ bool Algorithm::hasHiddenTriple() {
         
          /* 2:2 - X (Y | Y') (Y | Y') X (Y | Y') (Y | Y') X */
          if (c == algorithm.at(i+3)) {
-            if (o1 != algorithm.at(i+1) && o2 != algorithm.at(i+1))
+            if (!isParallel(c, algorithm.at(i+1)))
                 continue;
-            if (o1 != algorithm.at(i+2) && o2 != algorithm.at(i+2))
+            if (!isParallel(c, algorithm.at(i+2)))
                 continue;
-            if (o1 != algorithm.at(i+4) && o2 != algorithm.at(i+4))
+            if (!isParallel(c, algorithm.at(i+4)))
                 continue;
-            if (o1 != algorithm.at(i+5) && o2 != algorithm.at(i+5))
+            if (!isParallel(c, algorithm.at(i+5)))
                 continue;
             return true;
          }
@@ -485,7 +561,22 @@ bool Algorithm::hasHiddenTriple() {
     return false;
 }
 
-unsigned int Algorithm::getOppositeFace(unsigned long long int face) {
+/**
+ * Two different turns are parallel when they turn different layers on the same
+ * axis, so they commute. For a layer depth of one, that is the opposite face.
+ */
+bool Algorithm::isParallel(unsigned long long int a, unsigned long long int b) const {
+    if (layerDepth == 1)
+        return getOppositeFace(a) == b - b % 2;
+
+    unsigned long long int fa = a % ALGORITHM_BASE;
+    unsigned long long int fb = b % ALGORITHM_BASE;
+    if (getOppositeFace(fa) == fb - fb % 2)
+        return true;
+    return fa / 2 == fb / 2 && a / ALGORITHM_BASE != b / ALGORITHM_BASE;
+}
+
+unsigned int Algorithm::getOppositeFace(unsigned long long int face) const {
     switch (face) {
         case 0:      // Front
         case 1:
@@ -545,52 +636,68 @@ unsigned int Algorithm::getNumberForTurn(Turn turn) const {
 
    if (!turn.clockwise)
       number++;
+
+   unsigned int depth = turn.depth < layerDepth ? turn.depth : layerDepth - 1;
+   if (turn.wide && depth > 0)
+      number += (layerDepth - 1 + depth)*ALGORITHM_BASE;
+   else
+      number += depth*ALGORITHM_BASE;
    return number;
 }
 
 Turn Algorithm::getTurnForNumber(unsigned long long int number) const {
-   number = number % ALGORITHM_BASE;
-   switch (number) {
+   Turn turn;
+   number = number % algorithmBase;
+   switch (number % ALGORITHM_BASE) {
       case 0:
-         return {Layer::F, true};
+         turn = {Layer::F, true};
          break;
       case 1:
-         return {Layer::F, false};
+         turn = {Layer::F, false};
          break;
       case 2:
-         return {Layer::U, true};
+         turn = {Layer::U, true};
          break;
       case 3:
-         return {Layer::U, false};
+         turn = {Layer::U, false};
          break;
       case 4:
-         return {Layer::R, true};
+         turn = {Layer::R, true};
          break;
       case 5:
-         return {Layer::R, false};
+         turn = {Layer::R, false};
          break;
       case 6:
-         return {Layer::D, true};
+         turn = {Layer::D, true};
          break;
       case 7:
-         return {Layer::D, false};
+         turn = {Layer::D, false};
          break;
       case 8:
-         return {Layer::L, true};
+         turn = {Layer::L, true};
          break;
       case 9:
-         return {Layer::L, false};
+         turn = {Layer::L, false};
          break;
       case 10:
-         return {Layer::B, true};
+         turn = {Layer::B, true};
          break;
       case 11:
-         return {Layer::B, false};
+         turn = {Layer::B, false};
          break;
       default:
-         return {Layer::F, true};
+         turn = {Layer::F, true};
          break;
    }
+
+   unsigned int slice = (unsigned int)(number / ALGORITHM_BASE);
+   if (slice < layerDepth) {
+      turn.depth = slice;
+   } else {
+      turn.depth = slice - layerDepth + 1;
+      turn.wide = true;
+   }
+   return turn;
 }
 
 char Algorithm::layerToChar(Layer layer) {
@@ -660,3 +767,16 @@ Layer Algorithm::charToLayer(char lChar) {
          return Layer::NOLAYER;
    }
 }
+
+std::string Algorithm::turnToStr(Turn turn) {
+   std::string result = "";
+   if (turn.depth > 0 && !(turn.wide && turn.depth == 1))
+      result += std::to_string(turn.depth + 1);
+   result += layerToChar(turn.layer);
+
+   if (turn.wide && turn.depth > 0)
+      result += "w";
+   if (!turn.clockwise)
+      result += "\'";
+   return result;
+}
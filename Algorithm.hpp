@@ -36,6 +36,11 @@
  *    notation (https://www.speedsolving.com/wiki/index.php/NxNxN_Notation),
  *    such notation makes computing algorithms much more computationally
  *    difficult on a Rubik's Cube.
+ *
+ *    Larger cubes need turns that reach past the outer layer. The layer depth
+ *    (see setLayerDepth) extends the alphabet with inner slice turns (e.g. 2R)
+ *    and wide turns (e.g. Rw, 3Fw). A layer depth of one is the classic
+ *    alphabet of 12 fundamental turns.
  * 
  *    Patches are welcomed!
  * 
@@ -56,7 +61,14 @@
  *    removed from the end of a Vector in constant time (O(1)).
  *
  *    Because there are 12 fundamental turns, each field in an algorithm is
- *    treated as if it is a Base-12 number.
+ *    treated as if it is a Base-12 number. A layer depth of d adds d-1 inner
+ *    slices and d-1 wide turns per fundamental turn, so each field becomes a
+ *    Base-(12*(2d-1)) number. Field values are ordered by layer first, so the
+ *    value modulo 12 is always the fundamental turn:
+ *
+ *       0 - 11              F F' U U' R R' D D' L L' B B'
+ *       12*s - 12*s+11      (s+1)F ... (s+1)B'     for 0 < s < d
+ *       12*s - 12*s+11      (s-d+2)Fw ... Bw'      for d <= s < 2d-1
  *
  *    When a odometer rolls over to take up another significant digit (e.g. 99
  *    to 100, or 999 to 1000, etc.), the new significant digit is the second
@@ -96,9 +108,26 @@ enum Layer {
     NOLAYER
 };
 
+/**
+ * A turn of one or more parallel layers. The depth is the zero based index of
+ * the innermost layer turned, counted from the named face. A wide turn also
+ * turns every layer between the face and depth. The defaults describe a
+ * single outer layer turn, so {Layer::R, true} is simply R.
+ *
+ *    R   = {Layer::R, true, 0, false}
+ *    2R  = {Layer::R, true, 1, false}
+ *    Rw  = {Layer::R, true, 1, true}
+ *    3Rw = {Layer::R, true, 2, true}
+ */
 struct Turn {
+    constexpr Turn(Layer layer = Layer::NOLAYER, bool clockwise = true,
+                   unsigned int depth = 0, bool wide = false) :
+        layer(layer), clockwise(clockwise), depth(depth), wide(wide) {}
+
     Layer layer;
     bool clockwise;
+    unsigned int depth;
+    bool wide;
 };
 
 static const Turn initialTurn = {Layer::F, true};
@@ -134,7 +163,9 @@ class Algorithm {
         std::string getAlgorithmStr() const;
 
         /**
-         * @brief Get the Algorithm Number. Algorithms are zero indexed.
+         * @brief Get the Algorithm Number. Algorithms are zero indexed, so
+         * this is the number of times "F" must be incremented to reach this
+         * algorithm, however the algorithm was set.
          * 
          * @return unsigned long long int 
          */
@@ -166,6 +197,28 @@ class Algorithm {
         void addTurn(Turn turn);
         static char layerToChar(Layer layer);
         static Layer charToLayer(char lChar);
+        static std::string turnToStr(Turn turn);
+
+        /**
+         * @brief Set the number of layers per face that turns may reach. A
+         * depth of one is the classic Base-12 alphabet. Turns already in the
+         * algorithm are kept; turns deeper than a reduced depth are clamped
+         * to the deepest layer that remains. Adding a turn that is deeper
+         * than the current layer depth grows the layer depth to fit.
+         * 
+         * @param layerDepth The number of addressable layers per face.
+         */
+        void setLayerDepth(unsigned int layerDepth);
+        unsigned int getLayerDepth() const;
+
+        /**
+         * @brief Get the numerical base of each field in the algorithm. This
+         * is the size of the turn alphabet for the current layer depth.
+         * 
+         * @return unsigned int 
+         */
+        unsigned int getAlgorithmBase() const;
+        static unsigned int getAlgorithmBase(unsigned int layerDepth);
 
         /**
          * @brief Performs all redundancy checks.
@@ -196,6 +249,10 @@ class Algorithm {
          * A turn is a layer character (see Cube.h) and an optional single quote.
          * The optional single quote denotes an anti-clockwise turn. A turn that
          * does not include the single quote is assumed to be clockwise.
+         *
+         * The F, U, R, D, L, and B layers also accept an optional layer number
+         * prefix and an optional 'w' suffix (e.g. 2R, Rw, 3Fw') to select inner
+         * slice and wide turns. The layer depth grows to fit the deepest turn.
          */
         void setAlgorithm(const char* algorithm);
         void setAlgorithm(const std::vector<Turn> turns);
@@ -207,11 +264,19 @@ class Algorithm {
         std::vector<unsigned long long int> algorithm;
         unsigned int algorithmOrder = 0;
         unsigned long long int algorithmNumber = 0;
+        unsigned int layerDepth = 1;
+        unsigned int algorithmBase = ALGORITHM_BASE;
 
         void addToAlgorithm(const unsigned long long int addend);
+        void updateAlgorithmNumber();
+
+        /* Adds a turn at the highest index, without updating the number. */
+        void appendTurn(Turn turn);
+
         Turn getTurnForNumber(unsigned long long int number) const;
         unsigned int getNumberForTurn(Turn turn) const;
-        unsigned int getOppositeFace(unsigned long long int face);
+        unsigned int getOppositeFace(unsigned long long int face) const;
+        bool isParallel(unsigned long long int a, unsigned long long int b) const;
 };
 
 #endif // ALGORITHM_H
@@ -22,7 +22,11 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include "Cube.hpp"
 
@@ -48,24 +52,26 @@ Cube::Cube(CubieColor referenceColor, unsigned int cubeSize) {
 }
 
 Cube::Cube(const Cube& obj) {
-    cubeSize = obj.cubeSize;
-    fInitColor = obj.fInitColor;
-    initializeCube();
+    copyCubeAttributes(obj);
+    allocateCube();
     copyCube(obj);
 }
 
 Cube::Cube(Cube&& obj) {
     copyCubeAttributes(obj);
+    cube = obj.cube;
     obj.cube = nullptr;
-    obj.edges = nullptr;
 }
 
 Cube& Cube::operator=(const Cube& rhs) {
     if (&rhs != this) {
-        destroyCube();
-        cubeSize = rhs.cubeSize;
-        fInitColor = rhs.fInitColor;
-        initializeCube();
+        if (cubeSize != rhs.cubeSize) {
+            destroyCube();
+            copyCubeAttributes(rhs);
+            allocateCube();
+        } else {
+            copyCubeAttributes(rhs);
+        }
         copyCube(rhs);
     }
     return *this;
@@ -75,8 +81,8 @@ Cube& Cube::operator=(Cube&& rhs) {
     if (&rhs != this) {
         destroyCube();
         copyCubeAttributes(rhs);
+        cube = rhs.cube;
         rhs.cube = nullptr;
-        rhs.edges = nullptr;
     }
     return *this;
 }
@@ -85,11 +91,8 @@ bool Cube::operator==(const Cube& obj) {
     if (cubeSize != obj.cubeSize)
         return false;
 
-    for (unsigned int row=0; row<LAYERS_PER_COL*cubeSize; row++)
-        for (unsigned int col=0; col<LAYERS_PER_ROW*cubeSize; col++)
-            if (cube[row][col] != obj.cube[row][col])
-                return false;
-    return true;
+    return std::equal(cube[0], cube[0] + geometry->rows*geometry->cols,
+                      obj.cube[0]);
 }
 
 bool Cube::operator!=(const Cube& obj) {
@@ -102,45 +105,28 @@ Cube::~Cube() {
 
 void Cube::destroyCube() {
     if (cube != nullptr) {
-        for (unsigned int i=0; i<(LAYERS_PER_COL*cubeSize); i++)
-            delete[] cube[i];
+        delete[] cube[0];
         delete[] cube;
         cube = nullptr;
     }
-
-    if (edges != nullptr) {
-        delete[] edges;
-        edges = nullptr;
-    }
 }
 
 /* Copy semantics helper. */
 void Cube::copyCube(const Cube& from) {
-    for (unsigned int row=0; row<LAYERS_PER_COL*cubeSize; row++)
-        for (unsigned int col=0; col<LAYERS_PER_ROW*cubeSize; col++)
-            cube[row][col] = from.cube[row][col];
+    std::copy(from.cube[0], from.cube[0] + geometry->rows*geometry->cols,
+              cube[0]);
 }
 
-/* Move semantics helper. */
+/* Copy and move semantics helper. Everything but the cubies themselves. */
 void Cube::copyCubeAttributes(const Cube& from) {
     cubeSize   = from.cubeSize;
-    fInitColor = from.fInitColor;
-    cube       = from.cube;
-    edges      = from.edges;
+    geometry   = from.geometry;
     fInitColor = from.fInitColor;
     uInitColor = from.uInitColor;
     dInitColor = from.dInitColor;
     lInitColor = from.lInitColor;
     rInitColor = from.rInitColor;
     bInitColor = from.bInitColor;
-    fUpperLeft = from.fUpperLeft;
-    uUpperLeft = from.uUpperLeft;
-    lUpperLeft = from.lUpperLeft;
-    rUpperLeft = from.rUpperLeft;
-    fUpperLeftMax = from.fUpperLeftMax;
-    uUpperLeftMax = from.uUpperLeftMax;
-    lUpperLeftMax = from.lUpperLeftMax;
-    rUpperLeftMax = from.rUpperLeftMax;
 }
 
 unsigned int Cube::getCubeSize() {
@@ -148,13 +134,8 @@ unsigned int Cube::getCubeSize() {
 }
 
 std::vector<CubieColor> Cube::getCube() {
-   std::vector<CubieColor> tmp;
-
-    for (unsigned int row=0; row<LAYERS_PER_COL*cubeSize; row++)
-        for (unsigned int col=0; col<LAYERS_PER_ROW*cubeSize; col++)
-            tmp.push_back(cube[row][col]);
-
-    return tmp;
+    return std::vector<CubieColor>(cube[0],
+                                   cube[0] + geometry->rows*geometry->cols);
 }
 
 char Cube::cubieColorToChar(CubieColor cubie) {
@@ -188,13 +169,13 @@ char Cube::cubieColorToChar(CubieColor cubie) {
  * "Any four solved faces is sufficient to prove the entire cube is solved."
  */
 bool Cube::isSolved() {
-    if (!isSolved(fUpperLeft, fUpperLeftMax))
+    if (!isSolved(geometry->fUpperLeft, geometry->fUpperLeftMax))
         return false;
-    if (!isSolved(uUpperLeft, uUpperLeftMax))
+    if (!isSolved(geometry->uUpperLeft, geometry->uUpperLeftMax))
         return false;
-    if (!isSolved(lUpperLeft, lUpperLeftMax))
+    if (!isSolved(geometry->lUpperLeft, geometry->lUpperLeftMax))
         return false;
-    if (!isSolved(rUpperLeft, rUpperLeftMax))
+    if (!isSolved(geometry->rUpperLeft, geometry->rUpperLeftMax))
         return false;
     return true;
 }
@@ -216,28 +197,22 @@ void Cube::performAlgorithm(const std::vector<Turn> &algorithm) {
 void Cube::turn(Turn t) {
     switch (t.layer) {
         case Layer::F:
-            rotateLayer(t.layer, t.clockwise);
-            rotateEdges(Edges::UpFace, t.clockwise);
+            turnLayers(t, Edges::UpFace);
             break;
         case Layer::U:
-            rotateLayer(t.layer, t.clockwise);
-            rotateEdges(Edges::FaceUp, t.clockwise);
+            turnLayers(t, Edges::FaceUp);
             break;
         case Layer::R:
-            rotateLayer(t.layer, t.clockwise);
-            rotateEdges(Edges::UpRight, t.clockwise);
+            turnLayers(t, Edges::UpRight);
             break;
         case Layer::D:
-            rotateLayer(t.layer, t.clockwise);
-            rotateEdges(Edges::FaceDown, t.clockwise);
+            turnLayers(t, Edges::FaceDown);
             break;
         case Layer::L:
-            rotateLayer(t.layer, t.clockwise);
-            rotateEdges(Edges::UpLeft, t.clockwise);
+            turnLayers(t, Edges::UpLeft);
             break;
         case Layer::B:
-            rotateLayer(t.layer, t.clockwise);
-            rotateEdges(Edges::UpBack, t.clockwise);
+            turnLayers(t, Edges::UpBack);
             break;
         case Layer::M:
             turn({Layer::R, t.clockwise});
@@ -257,6 +232,25 @@ void Cube::turn(Turn t) {
    }
 }
 
+/**
+ * A turn moves the edges of every layer from its first depth through its
+ * depth. The face itself only rotates when the outer layer is included, and
+ * the opposite face rotates (in the other direction, as seen from that face)
+ * when the turn reaches the far side of the cube. Turns deeper than the cube
+ * are ignored.
+ */
+void Cube::turnLayers(Turn t, Edges start) {
+    if (t.depth >= cubeSize)
+        return;
+
+    unsigned int firstDepth = t.wide ? 0 : t.depth;
+    if (firstDepth == 0)
+        rotateLayer(t.layer, t.clockwise);
+    if (t.depth == cubeSize - 1)
+        rotateLayer(getOppositeLayer(t.layer), !t.clockwise);
+    rotateEdges(start, firstDepth, t.depth - firstDepth + 1, t.clockwise);
+}
+
 /**
  * The atomic element of a layer rotation is a four way circular cubie swap. The
  * four way swap is iterated over the outer edge of the layer. Then the sublayer 
@@ -267,16 +261,8 @@ void Cube::turn(Turn t) {
 void Cube::rotateLayer(Layer layer, bool clockwise) {
     unsigned int subCubeSize, subLayerMax;
     unsigned int ulr, ulc, urr, urc, llr, llc, lrr, lrc;
-
-    /**
-     * We have to set this to a throw-away value because -Ofast optimization
-     * causes an unassigned variable to emit -Werror=maybe-uninitialized. This
-     * warning cannot be squelched when using LLVM because of LLVM bug
-     * https://bugs.llvm.org/show_bug.cgi?id=24979
-     */
-    Coordinate ul = {Layer::U, true};
+    Coordinate ul = geometry->upperLeft[layer];
    
-    getLayerUpperLeft(ul, layer);
     subLayerMax = (unsigned int)ceil((float)cubeSize/2);
    
     for (unsigned int subLayer=0; subLayer<subLayerMax; subLayer++) {
@@ -302,13 +288,15 @@ void Cube::rotateLayer(Layer layer, bool clockwise) {
     }
 }
 
-void Cube::rotateEdges(Edges start, bool clockwise) {
-    unsigned int index0 = start*cubeSize;
-    unsigned int index1 = index0 + cubeSize;
-    unsigned int index2 = index1 + cubeSize;
-    unsigned int index3 = index2 + cubeSize;
+void Cube::rotateEdges(Edges start, unsigned int depth, unsigned int numLayers, bool clockwise) {
+    const Coordinate* edges = geometry->edges.data();
+    unsigned int edgeSize = cubeSize*cubeSize;
+    unsigned int index0 = getEdgeIndex(start, depth, 0, cubeSize);
+    unsigned int index1 = index0 + edgeSize;
+    unsigned int index2 = index1 + edgeSize;
+    unsigned int index3 = index2 + edgeSize;
    
-    for (unsigned int i=0; i<cubeSize; i++)
+    for (unsigned int i=0; i<numLayers*cubeSize; i++)
         fourWayRotate({{edges[index0 + i].row, edges[index0 + i].col},
                        {edges[index1 + i].row, edges[index1 + i].col},
                        {edges[index2 + i].row, edges[index2 + i].col},
@@ -345,32 +333,20 @@ void Cube::fourWayRotate(Square square, bool clockwise) {
 }
 
 void Cube::initializeCube() {
-    cube = new CubieColor*[LAYERS_PER_COL*cubeSize];
-    for (unsigned int i=0; i<(LAYERS_PER_COL*cubeSize); i++)
-        cube[i] = new CubieColor[LAYERS_PER_ROW*cubeSize];
+    geometry = getGeometry(cubeSize);
+    allocateCube();
 
-    for (unsigned int row=0; row<LAYERS_PER_COL*cubeSize; row++)
-        for (unsigned int col=0; col<LAYERS_PER_ROW*cubeSize; col++)
-            cube[row][col] = CubieColor::NOCOLOR;
-   
+    std::fill(cube[0], cube[0] + geometry->rows*geometry->cols,
+              CubieColor::NOCOLOR);
     initializeLayers();
-    initializeEdges();
-
-    getLayerUpperLeft(fUpperLeft, Layer::F);
-    fUpperLeftMax.row = fUpperLeft.row + cubeSize;
-    fUpperLeftMax.col = fUpperLeft.col + cubeSize;
-
-    getLayerUpperLeft(uUpperLeft, Layer::U);
-    uUpperLeftMax.row = uUpperLeft.row + cubeSize;
-    uUpperLeftMax.col = uUpperLeft.col + cubeSize;
-
-    getLayerUpperLeft(lUpperLeft, Layer::L);
-    lUpperLeftMax.row = lUpperLeft.row + cubeSize;
-    lUpperLeftMax.col = lUpperLeft.col + cubeSize;
+}
 
-    getLayerUpperLeft(rUpperLeft, Layer::R);
-    rUpperLeftMax.row = rUpperLeft.row + cubeSize;
-    rUpperLeftMax.col = rUpperLeft.col + cubeSize;
+/* The cubies are one contiguous block, so whole cube copies are one pass. */
+void Cube::allocateCube() {
+    cube = new CubieColor*[geometry->rows];
+    cube[0] = new CubieColor[geometry->rows*geometry->cols];
+    for (unsigned int i=1; i<geometry->rows; i++)
+        cube[i] = cube[0] + i*geometry->cols;
 }
 
 void Cube::initializeLayers() {
@@ -430,18 +406,64 @@ void Cube::initializeLayers() {
 }
 
 void Cube::initializeLayer(Layer layer, CubieColor color) {
+    Coordinate ul = geometry->upperLeft[layer];
+
+    for (unsigned int r = ul.row; r < (ul.row + cubeSize); r++)
+        for (unsigned int c = ul.col; c < (ul.col + cubeSize); c++)
+            cube[r][c] = color;
+}
+
+/**
+ * Geometries are never freed or modified once built, so the pointer handed out
+ * stays valid and may be read by any number of threads without locking.
+ */
+const Cube::Geometry* Cube::getGeometry(unsigned int cubeSize) {
+    static std::mutex geometryMutex;
+    static std::map<unsigned int, std::unique_ptr<Geometry>> geometries;
+
+    std::lock_guard<std::mutex> lock(geometryMutex);
+    std::unique_ptr<Geometry>& g = geometries[cubeSize];
+    if (!g) {
+        g.reset(new Geometry());
+        g->cubeSize = cubeSize;
+        initializeGeometry(*g);
+    }
+    return g.get();
+}
+
+void Cube::initializeGeometry(Geometry& g) {
+    unsigned int cubeSize = g.cubeSize;
+    g.rows = LAYERS_PER_COL*cubeSize;
+    g.cols = LAYERS_PER_ROW*cubeSize;
+
     /**
      * We have to set this to a throw-away value because -Ofast optimization
      * causes an unassigned variable to emit -Werror=maybe-uninitialized. This
      * warning cannot be squelched when using LLVM because of LLVM bug
      * https://bugs.llvm.org/show_bug.cgi?id=24979
      */
-    Coordinate ul = {Layer::U, true};
-    getLayerUpperLeft(ul, layer);
+    for (Coordinate& ul : g.upperLeft)
+        ul = {0, 0};
+    for (Layer l : {Layer::U, Layer::L, Layer::F, Layer::R, Layer::B, Layer::D})
+        getLayerUpperLeft(g.upperLeft[l], l, cubeSize);
 
-    for (unsigned int r = ul.row; r < (ul.row + cubeSize); r++)
-        for (unsigned int c = ul.col; c < (ul.col + cubeSize); c++)
-            cube[r][c] = color;
+    initializeEdges(g);
+
+    g.fUpperLeft = g.upperLeft[Layer::F];
+    g.fUpperLeftMax.row = g.fUpperLeft.row + cubeSize;
+    g.fUpperLeftMax.col = g.fUpperLeft.col + cubeSize;
+
+    g.uUpperLeft = g.upperLeft[Layer::U];
+    g.uUpperLeftMax.row = g.uUpperLeft.row + cubeSize;
+    g.uUpperLeftMax.col = g.uUpperLeft.col + cubeSize;
+
+    g.lUpperLeft = g.upperLeft[Layer::L];
+    g.lUpperLeftMax.row = g.lUpperLeft.row + cubeSize;
+    g.lUpperLeftMax.col = g.lUpperLeft.col + cubeSize;
+
+    g.rUpperLeft = g.upperLeft[Layer::R];
+    g.rUpperLeftMax.row = g.rUpperLeft.row + cubeSize;
+    g.rUpperLeftMax.col = g.rUpperLeft.col + cubeSize;
 }
 
 /**
@@ -449,180 +471,215 @@ void Cube::initializeLayer(Layer layer, CubieColor color) {
  * the layer that owns those edges. This mimicks standardized turn logic where
  * "clockwise" is relative to the layer you are turning.
  */
-void Cube::initializeEdges() {
-    edges = new Coordinate[NUM_EDGE_TYPES*cubeSize];
-
-    initializeFaceEdges();
-    initializeUpEdges();
-    initializeLeftEdges();
-    initializeRightEdges();
-    initializeDownEdges();
-    initializeBackEdges();
-}
-
-void Cube::initializeFaceEdges() {
-    Coordinate ul;
-    getLayerUpperLeft(ul, Layer::F);
-
-    for (unsigned int i=0; i<cubeSize; i++) {
-        Coordinate c1;
-        c1.row = ul.row - 1;
-        c1.col = ul.col + i;
-        edges[i + Edges::UpFace*cubeSize] = c1;
-
-        Coordinate c2;
-        c2.row = ul.row + i;
-        c2.col = ul.col + cubeSize;
-        edges[i + Edges::RightFace*cubeSize] = c2;
-
-        Coordinate c3;
-        c3.row = ul.row + cubeSize;
-        c3.col = ul.col + cubeSize - 1 - i;
-        edges[i + Edges::DownFace*cubeSize] = c3;
-
-        Coordinate c4;
-        c4.row = ul.row + cubeSize - 1 - i;
-        c4.col = ul.col - 1;
-        edges[i + Edges::LeftFace*cubeSize] = c4;
+void Cube::initializeEdges(Geometry& g) {
+    g.edges.resize(NUM_EDGE_TYPES*g.cubeSize*g.cubeSize);
+
+    initializeFaceEdges(g);
+    initializeUpEdges(g);
+    initializeLeftEdges(g);
+    initializeRightEdges(g);
+    initializeDownEdges(g);
+    initializeBackEdges(g);
+}
+
+void Cube::initializeFaceEdges(Geometry& g) {
+    unsigned int cubeSize = g.cubeSize;
+    Coordinate ul = g.upperLeft[Layer::F];
+
+    for (unsigned int d=0; d<cubeSize; d++) {
+        for (unsigned int i=0; i<cubeSize; i++) {
+            Coordinate c1;
+            c1.row = ul.row - 1 - d;
+            c1.col = ul.col + i;
+            g.edges[getEdgeIndex(Edges::UpFace, d, i, cubeSize)] = c1;
+
+            Coordinate c2;
+            c2.row = ul.row + i;
+            c2.col = ul.col + cubeSize + d;
+            g.edges[getEdgeIndex(Edges::RightFace, d, i, cubeSize)] = c2;
+
+            Coordinate c3;
+            c3.row = ul.row + cubeSize + d;
+            c3.col = ul.col + cubeSize - 1 - i;
+            g.edges[getEdgeIndex(Edges::DownFace, d, i, cubeSize)] = c3;
+
+            Coordinate c4;
+            c4.row = ul.row + cubeSize - 1 - i;
+            c4.col = ul.col - 1 - d;
+            g.edges[getEdgeIndex(Edges::LeftFace, d, i, cubeSize)] = c4;
+        }
     }
 }
 
-void Cube::initializeUpEdges() {
-    Coordinate ul;
-    getLayerUpperLeft(ul, Layer::U);
+void Cube::initializeUpEdges(Geometry& g) {
+    unsigned int cubeSize = g.cubeSize;
+    Coordinate ul = g.upperLeft[Layer::U];
 
-    for (unsigned int i=0; i<cubeSize; i++) {
-        Coordinate c1;
-        c1.row = cubeSize;
-        c1.col = ul.col + cubeSize - 1 - i;
-        edges[i + Edges::FaceUp*cubeSize] = c1;
+    for (unsigned int d=0; d<cubeSize; d++) {
+        for (unsigned int i=0; i<cubeSize; i++) {
+            Coordinate c1;
+            c1.row = cubeSize + d;
+            c1.col = ul.col + cubeSize - 1 - i;
+            g.edges[getEdgeIndex(Edges::FaceUp, d, i, cubeSize)] = c1;
 
-        Coordinate c2;
-        c2.row = cubeSize;
-        c2.col = ul.col - 1 - i;
-        edges[i + Edges::LeftUp*cubeSize] = c2;
+            Coordinate c2;
+            c2.row = cubeSize + d;
+            c2.col = ul.col - 1 - i;
+            g.edges[getEdgeIndex(Edges::LeftUp, d, i, cubeSize)] = c2;
 
-        Coordinate c3;
-        c3.row = cubeSize;
-        c3.col = ul.col + cubeSize*3 - 1 - i;
-        edges[i + Edges::BackUp*cubeSize] = c3;
+            Coordinate c3;
+            c3.row = cubeSize + d;
+            c3.col = ul.col + cubeSize*3 - 1 - i;
+            g.edges[getEdgeIndex(Edges::BackUp, d, i, cubeSize)] = c3;
 
-        Coordinate c4;
-        c4.row = cubeSize;
-        c4.col = ul.col + cubeSize*2 - 1 - i;
-        edges[i + Edges::RightUp*cubeSize] = c4;
+            Coordinate c4;
+            c4.row = cubeSize + d;
+            c4.col = ul.col + cubeSize*2 - 1 - i;
+            g.edges[getEdgeIndex(Edges::RightUp, d, i, cubeSize)] = c4;
+        }
     }
 }
 
-void Cube::initializeLeftEdges() {
-    Coordinate ul;
-    getLayerUpperLeft(ul, Layer::L);
+void Cube::initializeLeftEdges(Geometry& g) {
+    unsigned int cubeSize = g.cubeSize;
+    Coordinate ul = g.upperLeft[Layer::L];
 
-    for (unsigned int i=0; i<cubeSize; i++) {
-        Coordinate c1;
-        c1.row = i;
-        c1.col = cubeSize;
-        edges[i + Edges::UpLeft*cubeSize] = c1;
+    for (unsigned int d=0; d<cubeSize; d++) {
+        for (unsigned int i=0; i<cubeSize; i++) {
+            Coordinate c1;
+            c1.row = i;
+            c1.col = cubeSize + d;
+            g.edges[getEdgeIndex(Edges::UpLeft, d, i, cubeSize)] = c1;
 
-        Coordinate c2;
-        c2.row = ul.row + i;
-        c2.col = cubeSize;
-        edges[i + Edges::FaceLeft*cubeSize] = c2;
+            Coordinate c2;
+            c2.row = ul.row + i;
+            c2.col = cubeSize + d;
+            g.edges[getEdgeIndex(Edges::FaceLeft, d, i, cubeSize)] = c2;
 
-        Coordinate c3;
-        c3.row = ul.row + cubeSize + i;
-        c3.col = cubeSize;
-        edges[i + Edges::DownLeft*cubeSize] = c3;
+            Coordinate c3;
+            c3.row = ul.row + cubeSize + i;
+            c3.col = cubeSize + d;
+            g.edges[getEdgeIndex(Edges::DownLeft, d, i, cubeSize)] = c3;
 
-        Coordinate c4;
-        c4.row = ul.row + cubeSize - 1 - i;
-        c4.col = cubeSize*4 - 1;
-        edges[i + Edges::BackLeft*cubeSize] = c4;
+            Coordinate c4;
+            c4.row = ul.row + cubeSize - 1 - i;
+            c4.col = cubeSize*4 - 1 - d;
+            g.edges[getEdgeIndex(Edges::BackLeft, d, i, cubeSize)] = c4;
+        }
     }
 }
 
-void Cube::initializeRightEdges() {
-    Coordinate ul;
-    getLayerUpperLeft(ul, Layer::R);
+void Cube::initializeRightEdges(Geometry& g) {
+    unsigned int cubeSize = g.cubeSize;
+    Coordinate ul = g.upperLeft[Layer::R];
 
-    for (unsigned int i=0; i<cubeSize; i++) {
-        Coordinate c1;
-        c1.row = ul.row - 1 - i;
-        c1.col = ul.col - 1;
-        edges[i + Edges::UpRight*cubeSize] = c1;
+    for (unsigned int d=0; d<cubeSize; d++) {
+        for (unsigned int i=0; i<cubeSize; i++) {
+            Coordinate c1;
+            c1.row = ul.row - 1 - i;
+            c1.col = ul.col - 1 - d;
+            g.edges[getEdgeIndex(Edges::UpRight, d, i, cubeSize)] = c1;
 
-        Coordinate c2;
-        c2.row = ul.row + i;
-        c2.col = ul.col + cubeSize;
-        edges[i + Edges::BackRight*cubeSize] = c2;
+            Coordinate c2;
+            c2.row = ul.row + i;
+            c2.col = ul.col + cubeSize + d;
+            g.edges[getEdgeIndex(Edges::BackRight, d, i, cubeSize)] = c2;
 
-        Coordinate c3;
-        c3.row = ul.row + cubeSize*2 - 1 - i;
-        c3.col = ul.col - 1;
-        edges[i + Edges::DownRight*cubeSize] = c3;
+            Coordinate c3;
+            c3.row = ul.row + cubeSize*2 - 1 - i;
+            c3.col = ul.col - 1 - d;
+            g.edges[getEdgeIndex(Edges::DownRight, d, i, cubeSize)] = c3;
 
-        Coordinate c4;
-        c4.row = ul.row + cubeSize - 1 - i;
-        c4.col = ul.col - 1;
-        edges[i + Edges::FaceRight*cubeSize] = c4;
+            Coordinate c4;
+            c4.row = ul.row + cubeSize - 1 - i;
+            c4.col = ul.col - 1 - d;
+            g.edges[getEdgeIndex(Edges::FaceRight, d, i, cubeSize)] = c4;
+        }
     }
 }
 
-void Cube::initializeDownEdges() {
-    Coordinate ul;
-    getLayerUpperLeft(ul, Layer::D);
+void Cube::initializeDownEdges(Geometry& g) {
+    unsigned int cubeSize = g.cubeSize;
+    Coordinate ul = g.upperLeft[Layer::D];
 
-    for (unsigned int i=0; i<cubeSize; i++) {
-        Coordinate c1;
-        c1.row = ul.row - 1;
-        c1.col = ul.col + i;
-        edges[i + Edges::FaceDown*cubeSize] = c1;
+    for (unsigned int d=0; d<cubeSize; d++) {
+        for (unsigned int i=0; i<cubeSize; i++) {
+            Coordinate c1;
+            c1.row = ul.row - 1 - d;
+            c1.col = ul.col + i;
+            g.edges[getEdgeIndex(Edges::FaceDown, d, i, cubeSize)] = c1;
 
-        Coordinate c2;
-        c2.row = ul.row - 1;
-        c2.col = ul.col + cubeSize + i;
-        edges[i + Edges::RightDown*cubeSize] = c2;
+            Coordinate c2;
+            c2.row = ul.row - 1 - d;
+            c2.col = ul.col + cubeSize + i;
+            g.edges[getEdgeIndex(Edges::RightDown, d, i, cubeSize)] = c2;
 
-        Coordinate c3;
-        c3.row = ul.row - 1;
-        c3.col = ul.col + cubeSize*2 + i;
-        edges[i + Edges::BackDown*cubeSize] = c3;
+            Coordinate c3;
+            c3.row = ul.row - 1 - d;
+            c3.col = ul.col + cubeSize*2 + i;
+            g.edges[getEdgeIndex(Edges::BackDown, d, i, cubeSize)] = c3;
 
-        Coordinate c4;
-        c4.row = ul.row - 1;
-        c4.col = i;
-        edges[i + Edges::LeftDown*cubeSize] = c4;
+            Coordinate c4;
+            c4.row = ul.row - 1 - d;
+            c4.col = i;
+            g.edges[getEdgeIndex(Edges::LeftDown, d, i, cubeSize)] = c4;
+        }
     }
 }
 
-void Cube::initializeBackEdges() {
-    Coordinate ul;
-    getLayerUpperLeft(ul, Layer::B);
+void Cube::initializeBackEdges(Geometry& g) {
+    unsigned int cubeSize = g.cubeSize;
+    Coordinate ul = g.upperLeft[Layer::B];
+
+    for (unsigned int d=0; d<cubeSize; d++) {
+        for (unsigned int i=0; i<cubeSize; i++) {
+            Coordinate c1;
+            c1.row = d;
+            c1.col = cubeSize*2 - 1 - i;
+            g.edges[getEdgeIndex(Edges::UpBack, d, i, cubeSize)] = c1;
 
-    for (unsigned int i=0; i<cubeSize; i++) {
-        Coordinate c1;
-        c1.row = 0;
-        c1.col = cubeSize*2 - 1 - i;
-        edges[i + Edges::UpBack*cubeSize] = c1;
+            Coordinate c2;
+            c2.row = cubeSize + i;
+            c2.col = d;
+            g.edges[getEdgeIndex(Edges::LeftBack, d, i, cubeSize)] = c2;
 
-        Coordinate c2;
-        c2.row = cubeSize + i;
-        c2.col = 0;
-        edges[i + Edges::LeftBack*cubeSize] = c2;
+            Coordinate c3;
+            c3.row = cubeSize*3 - 1 - d;
+            c3.col = cubeSize + i;
+            g.edges[getEdgeIndex(Edges::DownBack, d, i, cubeSize)] = c3;
+
+            Coordinate c4;
+            c4.row = ul.row + cubeSize - 1 - i;
+            c4.col = ul.col - 1 - d;
+            g.edges[getEdgeIndex(Edges::RightBack, d, i, cubeSize)] = c4;
+        }
+    }
+}
 
-        Coordinate c3;
-        c3.row = cubeSize*3 - 1;
-        c3.col = cubeSize + i;
-        edges[i + Edges::DownBack*cubeSize] = c3;
+unsigned int Cube::getEdgeIndex(Edges edge, unsigned int depth, unsigned int i, unsigned int cubeSize) {
+    return (edge*cubeSize + depth)*cubeSize + i;
+}
 
-        Coordinate c4;
-        c4.row = ul.row + cubeSize - 1 - i;
-        c4.col = ul.col - 1;
-        edges[i + Edges::RightBack*cubeSize] = c4;
+Layer Cube::getOppositeLayer(Layer layer) {
+    switch (layer) {
+        case Layer::F:
+            return Layer::B;
+        case Layer::B:
+            return Layer::F;
+        case Layer::U:
+            return Layer::D;
+        case Layer::D:
+            return Layer::U;
+        case Layer::R:
+            return Layer::L;
+        case Layer::L:
+            return Layer::R;
+        default:
+            return Layer::NOLAYER;
     }
 }
 
-void Cube::getLayerUpperLeft(Coordinate& coord, Layer l) {
+void Cube::getLayerUpperLeft(Coordinate& coord, Layer l, unsigned int cubeSize) {
     /* Layers that are not (yet?) supported. */
     if (l == Layer::M || l == Layer::E || l == Layer::S)
         return;
@@ -27,10 +27,10 @@
  *    This class models a traditional cube. The user can select the reference
  *    color, the cube size, and affect turns.
  * 
- *    Rubik's cubes are size three (3x3x3). This class currently simulates
- *    moves for cubes of size two (2x2x2) and three (3x3x3). Larger cubes can
- *    be rendered, but some cubie combinations cannot be achieved because
- *    multi-layer moves are unsupported.
+ *    Rubik's cubes are size three (3x3x3). This class simulates moves for
+ *    cubes of size two (2x2x2) and up. Inner slice and wide turns (e.g. 2R,
+ *    Rw, 3Fw) reach the layers of larger cubes that outer turns cannot. See
+ *    Turn in Algorithm.hpp for how the depth of a turn is described.
  * 
  * Glossary of Terms:
  *    * Cubie: One discrete sub-cube on the cube. Corner cubies have three
@@ -58,6 +58,10 @@
  *    M = Middle   (Simulated by turning R and L in the same direction.)
  *    E = Equator  (Simulated by turning U and D in the same direction.)
  *    S = Standing (Simulated by turning F and B in the same direction.)
+ *
+ *    A number prefix selects an inner layer counted from the face (2R is the
+ *    layer just inside R), and a 'w' suffix turns every layer from the face
+ *    through that depth (Rw turns R and 2R together).
  * 
  * Internal Cube Model:
  *    The cube is modeled as a two dimensional (MxN) array representing an 
@@ -85,6 +89,10 @@
  *           BD -  5, 9  5,10  5,11; LD -  5, 0  5, 1  5, 2;
  *       (B) UB -  0, 5  0, 4  0, 3; LB -  3, 0  4, 0  5, 0;
  *           DB -  8, 3  8, 4  8, 5; RB -  5, 8  4, 8  3, 8;
+ *
+ *    Each edge is also stored for every depth, moving one row or column away
+ *    from its layer per depth. The edges of an edge type are contiguous from
+ *    depth zero up, so a wide turn cycles all of its depths in one pass.
  */
 
 #ifndef CUBE_HPP
@@ -151,29 +159,55 @@ class Cube {
             UpBack,   LeftBack,  DownBack,  RightBack  // B (back)
         };
 
+        /**
+         * Everything about a cube that depends only on its size. Each size has
+         * one immutable Geometry, built on first use and shared by every cube
+         * of that size, so constructing or copying a cube only touches the
+         * cubie colors.
+         */
+        struct Geometry {
+            unsigned int cubeSize;
+            unsigned int rows;
+            unsigned int cols;
+            std::vector<Coordinate> edges;
+            Coordinate upperLeft[Layer::NOLAYER];
+
+            /* Cache layer coordinates to speed up turning and solution checking. */
+            Coordinate fUpperLeft, fUpperLeftMax;
+            Coordinate uUpperLeft, uUpperLeftMax;
+            Coordinate lUpperLeft, lUpperLeftMax;
+            Coordinate rUpperLeft, rUpperLeftMax;
+        };
+
         void destroyCube();
         void copyCube(const Cube& from);
         void copyCubeAttributes(const Cube& from);
 
         void initializeCube();
+        void allocateCube();
 
         void initializeLayers();
         void initializeLayer(Layer layer, CubieColor color);
 
-        void initializeEdges();
-        void initializeFaceEdges();
-        void initializeUpEdges();
-        void initializeLeftEdges();
-        void initializeRightEdges();
-        void initializeDownEdges();
-        void initializeBackEdges();
-
+        static const Geometry* getGeometry(unsigned int cubeSize);
+        static void initializeGeometry(Geometry& g);
+        static void initializeEdges(Geometry& g);
+        static void initializeFaceEdges(Geometry& g);
+        static void initializeUpEdges(Geometry& g);
+        static void initializeLeftEdges(Geometry& g);
+        static void initializeRightEdges(Geometry& g);
+        static void initializeDownEdges(Geometry& g);
+        static void initializeBackEdges(Geometry& g);
+
+        void turnLayers(Turn t, Edges start);
         void rotateLayer(Layer layer, bool clockwise);
-        void rotateEdges(Edges start, bool clockwise);
+        void rotateEdges(Edges start, unsigned int depth, unsigned int numLayers, bool clockwise);
         void fourWayRotate(Square square, bool clockwise);
+        static unsigned int getEdgeIndex(Edges edge, unsigned int depth, unsigned int i, unsigned int cubeSize);
+        static Layer getOppositeLayer(Layer layer);
 
         bool isSolved(Coordinate upperLeft, Coordinate upperLeftMax);
-        void getLayerUpperLeft(Coordinate& coord, Layer l);
+        static void getLayerUpperLeft(Coordinate& coord, Layer l, unsigned int cubeSize);
 
         CubieColor fInitColor;
         CubieColor uInitColor;
@@ -184,19 +218,13 @@ class Cube {
 
         unsigned int cubeSize;
         CubieColor** cube;
-        Coordinate* edges;
-
-        unsigned int MIN_SIZE       = 2;
-        unsigned int DEFAULT_SIZE   = 3;
-        unsigned int LAYERS_PER_COL = 3;
-        unsigned int LAYERS_PER_ROW = 4;
-        unsigned int NUM_EDGE_TYPES = 24;
-
-        /* Cache layer coordinates to speed up turning and solution checking. */
-        Coordinate fUpperLeft, fUpperLeftMax;
-        Coordinate uUpperLeft, uUpperLeftMax;
-        Coordinate lUpperLeft, lUpperLeftMax;
-        Coordinate rUpperLeft, rUpperLeftMax;
+        const Geometry* geometry;
+
+        static const unsigned int MIN_SIZE       = 2;
+        static const unsigned int DEFAULT_SIZE   = 3;
+        static const unsigned int LAYERS_PER_COL = 3;
+        static const unsigned int LAYERS_PER_ROW = 4;
+        static const unsigned int NUM_EDGE_TYPES = 24;
 };
 
 #endif // CUBE_HPP
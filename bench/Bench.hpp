@@ -0,0 +1,192 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Timing and reporting shared by the benchmarks. A benchmark repeats an
+ *    operation enough times that one repetition takes at least minRepNs, so
+ *    the clock's overhead and resolution drop out. After some warmup
+ *    repetitions that are thrown away, it times a number of repetitions and
+ *    reports the median, 99th percentile, mean and minimum ns per operation.
+ *
+ *    Results are written as one JSON document, so runs before and after an
+ *    engine change can be compared by a script.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef BENCH_H
+#define BENCH_H
+
+struct BenchResult {
+    std::string name;
+    std::vector<std::pair<std::string, std::string>> labels; // Values are JSON.
+    uint64_t iterations = 0; // Operations per repetition.
+    double median = 0.0;     // ns per operation.
+    double p99 = 0.0;
+    double mean = 0.0;
+    double min = 0.0;
+
+    BenchResult& label(const std::string& key, const std::string& value) {
+        labels.emplace_back(key, quote(value));
+        return *this;
+    }
+
+    BenchResult& label(const std::string& key, unsigned long long int value) {
+        labels.emplace_back(key, std::to_string(value));
+        return *this;
+    }
+
+    BenchResult& label(const std::string& key, double value) {
+        labels.emplace_back(key, number(value));
+        return *this;
+    }
+
+    BenchResult& label(const std::string& key, bool value) {
+        labels.emplace_back(key, value ? "true" : "false");
+        return *this;
+    }
+
+    void write(std::ostream& out) const {
+        out << "{\"name\":" << quote(name);
+        for (const std::pair<std::string, std::string>& l : labels)
+            out << "," << quote(l.first) << ":" << l.second;
+        out << ",\"iterations\":" << iterations << ",\"median_ns\":" << number(median)
+            << ",\"p99_ns\":" << number(p99) << ",\"mean_ns\":" << number(mean)
+            << ",\"min_ns\":" << number(min) << "}";
+    }
+
+    static std::string quote(const std::string& s) {
+        std::string quoted = "\"";
+        for (char c : s) {
+            if (c == '"' || c == '\\')
+                quoted += '\\';
+            quoted += c;
+        }
+        return quoted + "\"";
+    }
+
+    static std::string number(double value) {
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%.3f", value);
+        return buf;
+    }
+};
+
+class BenchRunner {
+    public:
+        static const unsigned int DEFAULT_REPETITIONS = 51;
+        static const unsigned int DEFAULT_WARMUP = 5;
+        static const uint64_t DEFAULT_MIN_REP_NS = 200000;
+
+        BenchRunner(unsigned int repetitions = DEFAULT_REPETITIONS,
+                    unsigned int warmup = DEFAULT_WARMUP,
+                    uint64_t minRepNs = DEFAULT_MIN_REP_NS) :
+                    repetitions(repetitions < 1 ? 1 : repetitions), warmup(warmup),
+                    minRepNs(minRepNs) {}
+
+        /**
+         * @brief Time op, which performs one operation per call.
+         *
+         * @return BenchResult& The stored result, to add labels to. Valid
+         * until the next run.
+         */
+        template<typename Op>
+        BenchResult& run(const std::string& name, Op op) {
+            BenchResult result;
+            result.name = name;
+            result.iterations = calibrate(op);
+            for (unsigned int i = 0; i < warmup; i++)
+                time(op, result.iterations);
+
+            std::vector<double> samples;
+            for (unsigned int i = 0; i < repetitions; i++)
+                samples.push_back((double)time(op, result.iterations) / (double)result.iterations);
+            std::sort(samples.begin(), samples.end());
+
+            double sum = 0.0;
+            for (double s : samples)
+                sum += s;
+            result.median = percentile(samples, 0.5);
+            result.p99 = percentile(samples, 0.99);
+            result.mean = sum / (double)samples.size();
+            result.min = samples.front();
+            results.push_back(result);
+            return results.back();
+        }
+
+        /**
+         * @brief Write every result with the settings that produced them.
+         */
+        void write(std::ostream& out, const std::string& benchmark) const {
+            out << "{\"benchmark\":" << BenchResult::quote(benchmark)
+                << ",\"repetitions\":" << repetitions << ",\"warmup\":" << warmup
+                << ",\"min_rep_ns\":" << minRepNs << ",\"results\":[";
+            for (size_t i = 0; i < results.size(); i++) {
+                out << (i == 0 ? "\n  " : ",\n  ");
+                results[i].write(out);
+            }
+            out << "\n]}" << std::endl;
+        }
+
+    private:
+        unsigned int repetitions;
+        unsigned int warmup;
+        uint64_t minRepNs;
+        std::vector<BenchResult> results;
+
+        template<typename Op>
+        static uint64_t time(Op& op, uint64_t iterations) {
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; i++)
+                op();
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+
+        /* Double the iterations until one repetition takes minRepNs. */
+        template<typename Op>
+        uint64_t calibrate(Op& op) const {
+            uint64_t iterations = 1;
+            while (time(op, iterations) < minRepNs)
+                iterations *= 2;
+            return iterations;
+        }
+
+        /* Nearest rank, on sorted samples. */
+        static double percentile(const std::vector<double>& sorted, double p) {
+            size_t rank = (size_t)std::ceil(p * (double)sorted.size());
+            return sorted[rank < 1 ? 0 : rank - 1];
+        }
+};
+
+#endif // BENCH_H
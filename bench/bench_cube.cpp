@@ -0,0 +1,151 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Microbenchmarks of the cube simulation: each of the twelve quarter turns,
+ *    performAlgorithm, isSolved on a solved and a scrambled cube, copy and
+ *    move construction, and operator==, for several cube sizes.
+ *
+ *    Copy is a copy construction and the destruction of the copy. Move is a
+ *    move construction and a move assignment back into the source, so the
+ *    source is usable for the next operation.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "../Algorithm.hpp"
+#include "../Cube.hpp"
+#include "Bench.hpp"
+
+const unsigned int SIZES[] = {2, 3, 5, 10, 50};
+const Layer LAYERS[] = {Layer::F, Layer::U, Layer::R, Layer::D, Layer::L, Layer::B};
+
+/* Sinks for results, so the compiler keeps the calls. */
+volatile bool sink;
+
+void usage(const char* name);
+
+int main(int argc, char *argv[]) {
+    int ch;
+    unsigned int repetitions = BenchRunner::DEFAULT_REPETITIONS;
+    unsigned int warmup = BenchRunner::DEFAULT_WARMUP;
+    uint64_t minRepNs = BenchRunner::DEFAULT_MIN_REP_NS;
+    char* outputPath = nullptr;
+
+    while ((ch = getopt(argc, argv, "r:w:m:o:h")) != -1) {
+        switch (ch) {
+            case 'r':
+                repetitions = (unsigned int)std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'w':
+                warmup = (unsigned int)std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'm':
+                minRepNs = 1000*std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return ch == 'h' ? 0 : 1;
+        }
+    }
+
+    /* Any mix of faces and directions will do. */
+    std::vector<Turn> algorithm = {{Layer::R, true}, {Layer::U, true}, {Layer::R, false},
+                                   {Layer::U, false}, {Layer::F, true}, {Layer::D, false},
+                                   {Layer::B, true}};
+
+    BenchRunner runner(repetitions, warmup, minRepNs);
+    for (unsigned int size : SIZES) {
+        Cube c(CubieColor::RED, size);
+        for (Layer layer : LAYERS) {
+            for (bool clockwise : {true, false}) {
+                Turn turn(layer, clockwise);
+                runner.run("turn", [&] { c.turn(turn); })
+                      .label("size", (unsigned long long int)size)
+                      .label("move", Algorithm::turnToStr(turn));
+            }
+        }
+
+        runner.run("performAlgorithm", [&] { c.performAlgorithm(algorithm); })
+              .label("size", (unsigned long long int)size)
+              .label("turns", (unsigned long long int)algorithm.size());
+
+        Cube solved(CubieColor::RED, size);
+        runner.run("isSolved", [&] { sink = solved.isSolved(); })
+              .label("size", (unsigned long long int)size)
+              .label("state", std::string("solved"));
+
+        Cube scrambled(CubieColor::RED, size);
+        scrambled.performAlgorithm(algorithm);
+        runner.run("isSolved", [&] { sink = scrambled.isSolved(); })
+              .label("size", (unsigned long long int)size)
+              .label("state", std::string("scrambled"));
+
+        runner.run("copy", [&] { Cube copy(solved); })
+              .label("size", (unsigned long long int)size);
+
+        runner.run("move", [&] { Cube moved(std::move(solved)); solved = std::move(moved); })
+              .label("size", (unsigned long long int)size);
+
+        Cube other(solved);
+        runner.run("operator==", [&] { sink = solved == other; })
+              .label("size", (unsigned long long int)size)
+              .label("state", std::string("equal"));
+    }
+
+    if (outputPath == nullptr) {
+        runner.write(std::cout, "cube");
+        return 0;
+    }
+    std::ofstream out(outputPath, std::ios::trunc);
+    runner.write(out, "cube");
+    if (!out) {
+        std::cerr << "Unable to write " << outputPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+void usage(const char* name) {
+    std::cerr << "usage: " << name << " [-r repetitions] [-w warmup] [-m min_rep_us] "
+              << "[-o output]" << std::endl;
+    std::cerr << " -r - Timed repetitions of each benchmark, " << BenchRunner::DEFAULT_REPETITIONS
+              << " by default." << std::endl;
+    std::cerr << " -w - Repetitions run first and thrown away, " << BenchRunner::DEFAULT_WARMUP
+              << " by default." << std::endl;
+    std::cerr << " -m - Shortest repetition in microseconds, "
+              << BenchRunner::DEFAULT_MIN_REP_NS/1000 << " by default." << std::endl;
+    std::cerr << " -o - Write the JSON results here instead of stdout." << std::endl;
+}
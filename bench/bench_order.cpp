@@ -0,0 +1,255 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    End to end order throughput on fixed workloads: walking a range of
+ *    algorithms the way a --count search does, skipping redundant ones and
+ *    computing the order of the rest, and computing the order of a fixed set
+ *    of high order algorithms. Each workload reports algorithms walked per
+ *    second and orders computed per second, from the median repetition.
+ *
+ *    With -s the results are saved as a baseline. With -b they are compared
+ *    to a saved baseline, and the run fails if any workload's rate dropped by
+ *    more than the threshold. Only baselines written by this program can be
+ *    read back.
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../Algorithm.hpp"
+#include "../Cube.hpp"
+#include "Bench.hpp"
+
+struct RangeWorkload {
+    const char* start;
+    unsigned long long int count;
+};
+
+/* Short algorithms like a default search, and a stretch of six turn ones. */
+const RangeWorkload RANGES[] = {{"U", 20000}, {"F F F F F F", 10000}};
+
+/* Found by --find-orders from U; the highest orders up to six turns. */
+const char* HIGH_ORDER[] = {"F F U B' R B'", "F U F L D' B'", "F F U L B'",
+                            "F F U R' D' B", "F F U F D B'", "F F U F' R' D"};
+
+const unsigned int DEFAULT_REPETITIONS = 5;
+const unsigned int DEFAULT_WARMUP = 1;
+const double DEFAULT_THRESHOLD = 10.0;
+const uint64_t MIN_REP_NS = 50000000;
+
+unsigned int computeOrder(const std::vector<Turn>& turnSet, Cube& c);
+std::string getField(const std::string& json, const std::string& key);
+int compare(const std::string& path, const std::vector<BenchResult>& results, const double threshold);
+void usage(const char* name);
+
+int main(int argc, char *argv[]) {
+    int ch;
+    unsigned int repetitions = DEFAULT_REPETITIONS;
+    unsigned int warmup = DEFAULT_WARMUP;
+    double threshold = DEFAULT_THRESHOLD;
+    char* outputPath = nullptr;
+    char* savePath = nullptr;
+    char* baselinePath = nullptr;
+
+    while ((ch = getopt(argc, argv, "r:w:o:s:b:x:h")) != -1) {
+        switch (ch) {
+            case 'r':
+                repetitions = (unsigned int)std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'w':
+                warmup = (unsigned int)std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            case 's':
+                savePath = optarg;
+                break;
+            case 'b':
+                baselinePath = optarg;
+                break;
+            case 'x':
+                threshold = std::strtod(optarg, nullptr);
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return ch == 'h' ? 0 : 1;
+        }
+    }
+
+    /* Long enough to time the high order set; a range is one pass per repetition. */
+    BenchRunner runner(repetitions, warmup, MIN_REP_NS);
+    std::vector<BenchResult> results;
+    Cube c(CubieColor::RED, 3);
+
+    for (const RangeWorkload& range : RANGES) {
+        Algorithm first(range.start);
+        unsigned long long int evaluated = 0;
+        BenchResult& result = runner.run("range", [&] {
+            Algorithm algorithm(first);
+            evaluated = 0;
+            for (unsigned long long int i = 0; i < range.count; i++, ++algorithm) {
+                if (algorithm.isRedundant())
+                    continue;
+                computeOrder(algorithm.getAlgorithm(), c);
+                ++evaluated;
+            }
+        });
+        result.label("workload", "range " + std::string(range.start) + " +" + std::to_string(range.count))
+              .label("algorithms", range.count)
+              .label("orders", evaluated)
+              .label("algorithms_per_s", 1e9*(double)range.count/result.median)
+              .label("orders_per_s", 1e9*(double)evaluated/result.median);
+        results.push_back(result);
+    }
+
+    std::vector<std::vector<Turn>> highOrder;
+    for (const char* alg : HIGH_ORDER)
+        highOrder.push_back(Algorithm(alg).getAlgorithm());
+    unsigned long long int turns = 0;
+    BenchResult& result = runner.run("orders", [&] {
+        turns = 0;
+        for (const std::vector<Turn>& turnSet : highOrder)
+            turns += computeOrder(turnSet, c)*turnSet.size();
+    });
+    result.label("workload", std::string("high order"))
+          .label("algorithms", (unsigned long long int)highOrder.size())
+          .label("orders", (unsigned long long int)highOrder.size())
+          .label("turns", turns)
+          .label("algorithms_per_s", 1e9*(double)highOrder.size()/result.median)
+          .label("orders_per_s", 1e9*(double)highOrder.size()/result.median);
+    results.push_back(result);
+
+    if (outputPath == nullptr) {
+        runner.write(std::cout, "order");
+    } else {
+        std::ofstream out(outputPath, std::ios::trunc);
+        runner.write(out, "order");
+        if (!out) {
+            std::cerr << "Unable to write " << outputPath << std::endl;
+            return 1;
+        }
+    }
+
+    if (savePath != nullptr) {
+        std::ofstream out(savePath, std::ios::trunc);
+        runner.write(out, "order");
+        if (!out) {
+            std::cerr << "Unable to write " << savePath << std::endl;
+            return 1;
+        }
+    }
+
+    return baselinePath != nullptr ? compare(baselinePath, results, threshold) : 0;
+}
+
+/* c must start solved and is left solved. */
+unsigned int computeOrder(const std::vector<Turn>& turnSet, Cube& c) {
+    unsigned int order = 0;
+    do {
+        ++order;
+        c.performAlgorithm(turnSet);
+    } while (!c.isSolved());
+    return order;
+}
+
+/* The raw JSON value of key in one result line, or "" if it has none. */
+std::string getField(const std::string& json, const std::string& key) {
+    std::string quoted = "\"" + key + "\":";
+    size_t start = json.find(quoted);
+    if (start == std::string::npos)
+        return "";
+    start += quoted.size();
+    size_t end = json[start] == '"' ? json.find('"', start + 1) + 1 : json.find_first_of(",}", start);
+    return json.substr(start, end - start);
+}
+
+/**
+ * Print each workload's rate against the baseline. Returns 1 if any rate is
+ * more than threshold percent below the baseline or a workload is missing.
+ */
+int compare(const std::string& path, const std::vector<BenchResult>& results, const double threshold) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Unable to read baseline " << path << std::endl;
+        return 1;
+    }
+
+    std::map<std::string, double> baseline;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string workload = getField(line, "workload");
+        std::string rate = getField(line, "algorithms_per_s");
+        if (!workload.empty() && !rate.empty())
+            baseline[workload] = std::strtod(rate.c_str(), nullptr);
+    }
+
+    int status = 0;
+    std::cerr << "Algorithms/s against " << path << ", failing below -" << threshold << "%" << std::endl;
+    for (const BenchResult& result : results) {
+        std::ostringstream json;
+        result.write(json);
+        std::string workload = getField(json.str(), "workload");
+        double rate = std::strtod(getField(json.str(), "algorithms_per_s").c_str(), nullptr);
+
+        std::map<std::string, double>::const_iterator base = baseline.find(workload);
+        if (base == baseline.end()) {
+            std::cerr << "  " << workload.substr(1, workload.size() - 2) << ": not in the baseline" << std::endl;
+            status = 1;
+            continue;
+        }
+        double change = base->second > 0.0 ? 100.0*(rate/base->second - 1.0) : 0.0;
+        bool regressed = change < -threshold;
+        char row[160];
+        std::snprintf(row, sizeof(row), "  %-24s %14.1f -> %14.1f %+7.1f%%%s",
+                      workload.substr(1, workload.size() - 2).c_str(),
+                      base->second, rate, change, regressed ? "  REGRESSED" : "");
+        std::cerr << row << std::endl;
+        status = regressed ? 1 : status;
+    }
+    return status;
+}
+
+void usage(const char* name) {
+    std::cerr << "usage: " << name << " [-r repetitions] [-w warmup] [-o output] "
+              << "[-s save_baseline] [-b baseline] [-x threshold]" << std::endl;
+    std::cerr << " -r - Timed repetitions of each workload, " << DEFAULT_REPETITIONS
+              << " by default." << std::endl;
+    std::cerr << " -w - Repetitions run first and thrown away, " << DEFAULT_WARMUP
+              << " by default." << std::endl;
+    std::cerr << " -o - Write the JSON results here instead of stdout." << std::endl;
+    std::cerr << " -s - Also save the results as a baseline." << std::endl;
+    std::cerr << " -b - Compare against this baseline and fail on a regression." << std::endl;
+    std::cerr << " -x - Percent drop in algorithms/s that counts as a regression, "
+              << DEFAULT_THRESHOLD << " by default." << std::endl;
+}
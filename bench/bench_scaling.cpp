@@ -0,0 +1,249 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    How the parallel parts scale with threads: the redundancy reduction of
+ *    Algorithms::getReduction, and an order search that walks chunks from a
+ *    RangeScheduler and writes through a ResultWriter like the cli does. Each
+ *    runs at 1, 2, 4 ... threads up to the hardware concurrency, and at that
+ *    count if it is not a power of two.
+ *
+ *    Strong scaling keeps the work fixed, so the speedup is t1/tN and the
+ *    efficiency the speedup over N. Weak scaling gives each thread the same
+ *    work, so the efficiency is t1/tN and the speedup N times that.
+ *
+ *    Peak RSS is the kernel's high water mark, reset through
+ *    /proc/self/clear_refs before each run. Where that is not allowed the
+ *    mark only grows, and rss_reset is false.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../Algorithm.hpp"
+#include "../Cube.hpp"
+#include "../order/AlgorithmTally.hpp"
+#include "../order/RangeScheduler.hpp"
+#include "../order/ResultWriter.hpp"
+#include "../order/ThreadPool.hpp"
+#include "Bench.hpp"
+
+const unsigned long long int DEFAULT_REDUCE_SIZE = 10000000;
+const unsigned long long int DEFAULT_SEARCH_COUNT = 20000;
+const unsigned long long int CHUNK_SIZE = 4096;
+const unsigned long long int FLUSH_MS = 100;
+const unsigned int DEFAULT_REPETITIONS = 3;
+
+bool rssReset = true;
+unsigned long long int peakRss;
+
+void resetPeakRss();
+unsigned long long int readPeakRss();
+void search(unsigned int numThreads, unsigned long long int count, int fd);
+void scale(BenchRunner& runner, const std::string& name, const std::vector<unsigned int>& threadCounts,
+           bool weak, unsigned long long int work,
+           const std::function<void(unsigned int, unsigned long long int)>& run);
+void usage(const char* name);
+
+int main(int argc, char *argv[]) {
+    int ch;
+    unsigned int maxThreads = std::thread::hardware_concurrency();
+    unsigned int repetitions = DEFAULT_REPETITIONS;
+    unsigned long long int reduceSize = DEFAULT_REDUCE_SIZE;
+    unsigned long long int searchCount = DEFAULT_SEARCH_COUNT;
+    char* outputPath = nullptr;
+
+    while ((ch = getopt(argc, argv, "t:r:n:c:o:h")) != -1) {
+        switch (ch) {
+            case 't':
+                maxThreads = (unsigned int)std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'r':
+                repetitions = (unsigned int)std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'n':
+                reduceSize = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'c':
+                searchCount = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'o':
+                outputPath = optarg;
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return ch == 'h' ? 0 : 1;
+        }
+    }
+
+    std::vector<unsigned int> threadCounts;
+    for (unsigned int n = 1; n < maxThreads; n *= 2)
+        threadCounts.push_back(n);
+    threadCounts.push_back(maxThreads < 1 ? 1 : maxThreads);
+
+    int devNull = open("/dev/null", O_WRONLY);
+    if (devNull < 0) {
+        std::cerr << "Unable to open /dev/null" << std::endl;
+        return 1;
+    }
+
+    /* A run is far longer than the minimum, so the one calibration run is the warmup. */
+    BenchRunner runner(repetitions, 0, 1);
+    auto reduce = [](unsigned int numThreads, unsigned long long int size) {
+        ThreadPool pool(numThreads);
+        Algorithms algorithms(numThreads, size, &Algorithm::isRedundant, &pool);
+        algorithms.getReduction();
+    };
+    auto order = [devNull](unsigned int numThreads, unsigned long long int count) {
+        search(numThreads, count, devNull);
+    };
+    for (bool weak : {false, true}) {
+        scale(runner, "reduce", threadCounts, weak, reduceSize, reduce);
+        scale(runner, "search", threadCounts, weak, searchCount, order);
+    }
+    close(devNull);
+
+    if (outputPath == nullptr) {
+        runner.write(std::cout, "scaling");
+        return 0;
+    }
+    std::ofstream out(outputPath, std::ios::trunc);
+    runner.write(out, "scaling");
+    if (!out) {
+        std::cerr << "Unable to write " << outputPath << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Time run at each thread count. Weak scaling multiplies work by the thread
+ * count. The median time at one thread is the reference for the others.
+ */
+void scale(BenchRunner& runner, const std::string& name, const std::vector<unsigned int>& threadCounts,
+           bool weak, unsigned long long int work,
+           const std::function<void(unsigned int, unsigned long long int)>& run) {
+    double reference = 0.0;
+    for (unsigned int numThreads : threadCounts) {
+        unsigned long long int size = weak ? work*numThreads : work;
+        peakRss = 0;
+        BenchResult& result = runner.run(name, [&] {
+            resetPeakRss();
+            run(numThreads, size);
+            peakRss = std::max(peakRss, readPeakRss());
+        });
+        if (numThreads == threadCounts.front())
+            reference = result.median*threadCounts.front();
+        double efficiency = weak ? reference/result.median : reference/(result.median*numThreads);
+        result.label("scaling", std::string(weak ? "weak" : "strong"))
+              .label("threads", (unsigned long long int)numThreads)
+              .label("work", size)
+              .label("speedup", efficiency*numThreads)
+              .label("efficiency", efficiency)
+              .label("peak_rss_kb", peakRss)
+              .label("rss_reset", rssReset);
+        std::cerr << name << " " << (weak ? "weak" : "strong") << " " << numThreads
+                  << " threads: " << result.median/1e6 << " ms, efficiency "
+                  << efficiency << std::endl;
+    }
+}
+
+/* Threads take chunks like calculateOrder, and write each order found. */
+void search(unsigned int numThreads, unsigned long long int count, int fd) {
+    RangeScheduler scheduler(numThreads, 0, count, CHUNK_SIZE);
+    ResultWriter writer(numThreads, fd, FLUSH_MS);
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < numThreads; i++) {
+        threads.emplace_back([&scheduler, &writer, i] {
+            Algorithm algorithm;
+            Algorithm initial;
+            Cube c(CubieColor::RED, 3);
+            RangeScheduler::Range range;
+            unsigned long long int position = 0;
+            while (scheduler.next(i, range)) {
+                if (range.start < position) {
+                    algorithm = initial;
+                    position = 0;
+                }
+                algorithm += range.start - position;
+                for (unsigned long long int n = range.start; n < range.end; ++n, ++algorithm) {
+                    if (algorithm.isRedundant())
+                        continue;
+                    std::vector<Turn> turnSet = algorithm.getAlgorithm();
+                    unsigned int order = 0;
+                    do {
+                        ++order;
+                        c.performAlgorithm(turnSet);
+                    } while (!c.isSolved());
+                    writer.pushResult(i, i, n, turnSet, order);
+                }
+                position = range.end;
+                writer.pushChunk(i, range.chunk);
+            }
+        });
+    }
+    for (std::thread& t : threads)
+        t.join();
+}
+
+/* Writing 5 to clear_refs resets VmHWM to the current RSS. */
+void resetPeakRss() {
+    std::ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5" << std::endl;
+    if (!clearRefs)
+        rssReset = false;
+}
+
+/* VmHWM in kB, or 0 if it can't be read. */
+unsigned long long int readPeakRss() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line))
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return std::strtoull(line.c_str() + 6, nullptr, 10);
+    return 0;
+}
+
+void usage(const char* name) {
+    std::cerr << "usage: " << name << " [-t max_threads] [-r repetitions] [-n reduce_size] "
+              << "[-c search_count] [-o output]" << std::endl;
+    std::cerr << " -t - Most threads to run with, the hardware concurrency by default." << std::endl;
+    std::cerr << " -r - Timed runs of each configuration, " << DEFAULT_REPETITIONS
+              << " by default." << std::endl;
+    std::cerr << " -n - Algorithms reduced per run, or per thread for weak scaling, "
+              << DEFAULT_REDUCE_SIZE << " by default." << std::endl;
+    std::cerr << " -c - Algorithms searched per run, or per thread for weak scaling, "
+              << DEFAULT_SEARCH_COUNT << " by default." << std::endl;
+    std::cerr << " -o - Write the JSON results here instead of stdout." << std::endl;
+}
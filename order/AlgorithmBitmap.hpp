@@ -0,0 +1,403 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    A compressed set of algorithm numbers, laid out like a roaring bitmap.
+ *    The index space is cut into blocks of 2^16 numbers, and each non-empty
+ *    block is stored as a container. A container holds a sorted array of
+ *    16 bit offsets while it has at most ARRAY_MAX members, and a 2^16 bit
+ *    bitmap after that. Either way, no container uses more than 8KiB, so a
+ *    dense set costs about one bit per algorithm number instead of eight
+ *    bytes.
+ *
+ *    Numbers must be added in ascending order, which is how a reduction leaf
+ *    walks its slice. Containers are grouped into segments that are shared,
+ *    never copied. Appending a set whose numbers all follow this one only
+ *    copies pointers to its segments, so combining two disjoint leaf slices
+ *    is a concatenation.
+ *
+ *    The serialized form is written in host byte order:
+ *       "ABMP" <u32 version> <u64 size> <u64 containers>
+ *       then for each container:
+ *       <u64 key> <u8 type> <u32 cardinality> <payload>
+ *    where the payload is cardinality u16 offsets for an array container and
+ *    BITMAP_WORDS u64 words for a bitmap container.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef ALGORITHMBITMAP_H
+#define ALGORITHMBITMAP_H
+
+class AlgorithmBitmap {
+    private:
+        static const unsigned int CONTAINER_BITS = 16;
+        static const unsigned int CONTAINER_SIZE = 1 << CONTAINER_BITS;
+        static const unsigned int BITMAP_WORDS = CONTAINER_SIZE / 64;
+        static const unsigned int ARRAY_MAX = 4096;
+        static const uint32_t VERSION = 1;
+
+        struct Container {
+            unsigned long long int key;
+            uint32_t cardinality = 0;
+            std::vector<uint16_t> array;
+            std::vector<uint64_t> bits;
+
+            bool isBitmap() const {
+                return !bits.empty();
+            }
+
+            void add(uint16_t offset) {
+                if (!isBitmap() && cardinality == ARRAY_MAX) {
+                    bits.assign(BITMAP_WORDS, 0);
+                    for (uint16_t o : array)
+                        bits[o >> 6] |= 1ULL << (o & 63);
+                    std::vector<uint16_t>().swap(array);
+                }
+                if (isBitmap())
+                    bits[offset >> 6] |= 1ULL << (offset & 63);
+                else
+                    array.push_back(offset);
+                ++cardinality;
+            }
+
+            bool contains(uint16_t offset) const {
+                if (isBitmap())
+                    return (bits[offset >> 6] >> (offset & 63)) & 1;
+                return std::binary_search(array.begin(), array.end(), offset);
+            }
+
+            unsigned long long int getFirst() const {
+                return (key << CONTAINER_BITS) + (isBitmap() ? next(0) : array.front());
+            }
+
+            unsigned long long int getLast() const {
+                unsigned long long int offset = 0;
+                if (!isBitmap())
+                    offset = array.back();
+                for (unsigned int w = BITMAP_WORDS; isBitmap() && w-- > 0; )
+                    if (bits[w] != 0) {
+                        offset = w*64 + 63 - (unsigned int)__builtin_clzll(bits[w]);
+                        break;
+                    }
+                return (key << CONTAINER_BITS) + offset;
+            }
+
+            /* Arrays must be strictly ascending and bitmaps must hold cardinality bits. */
+            bool isValid() const {
+                if (!isBitmap())
+                    return std::adjacent_find(array.begin(), array.end(),
+                                              std::greater_equal<uint16_t>()) == array.end();
+                unsigned long long int count = 0;
+                for (uint64_t word : bits)
+                    count += (unsigned long long int)__builtin_popcountll(word);
+                return count == cardinality;
+            }
+
+            /* Offset of the first member at or after position, or CONTAINER_SIZE. */
+            unsigned int next(unsigned int position) const {
+                if (!isBitmap())
+                    return position < cardinality ? position : CONTAINER_SIZE;
+                unsigned int w = position >> 6;
+                if (w >= BITMAP_WORDS)
+                    return CONTAINER_SIZE;
+                uint64_t word = bits[w] & (~0ULL << (position & 63));
+                while (word == 0) {
+                    if (++w == BITMAP_WORDS)
+                        return CONTAINER_SIZE;
+                    word = bits[w];
+                }
+                return w*64 + (unsigned int)__builtin_ctzll(word);
+            }
+        };
+
+        struct Segment {
+            std::vector<Container> containers;
+        };
+
+        std::vector<std::shared_ptr<const Segment>> segments;
+        std::shared_ptr<Segment> building;
+        unsigned long long int cardinality = 0;
+        unsigned long long int last = 0;
+
+    public:
+        /**
+         * Forward iterator over the members in ascending order.
+         */
+        class const_iterator {
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef unsigned long long int value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const unsigned long long int* pointer;
+                typedef unsigned long long int reference;
+
+                reference operator*() const {
+                    const Container& c = getContainer();
+                    unsigned long long int offset = c.isBitmap() ? position : c.array[position];
+                    return (c.key << CONTAINER_BITS) + offset;
+                }
+
+                const_iterator& operator++() {
+                    position = getContainer().next(position + 1);
+                    if (position == CONTAINER_SIZE)
+                        nextContainer();
+                    return *this;
+                }
+
+                const_iterator operator++(int) {
+                    const_iterator i = *this;
+                    ++(*this);
+                    return i;
+                }
+
+                bool operator==(const const_iterator& i) const {
+                    return segment == i.segment && container == i.container && position == i.position;
+                }
+
+                bool operator!=(const const_iterator& i) const {
+                    return !(*this == i);
+                }
+
+            private:
+                friend class AlgorithmBitmap;
+                const AlgorithmBitmap* bitmap;
+                size_t segment;
+                size_t container;
+                unsigned int position;
+
+                const_iterator(const AlgorithmBitmap* bitmap, size_t segment) :
+                    bitmap(bitmap), segment(segment), container(0), position(0) {
+                    skipEmptySegments();
+                }
+
+                const Container& getContainer() const {
+                    return bitmap->segments[segment]->containers[container];
+                }
+
+                void nextContainer() {
+                    ++container;
+                    skipEmptySegments();
+                }
+
+                void skipEmptySegments() {
+                    while (segment < bitmap->segments.size() &&
+                           container == bitmap->segments[segment]->containers.size()) {
+                        ++segment;
+                        container = 0;
+                    }
+                    position = segment < bitmap->segments.size() ? getContainer().next(0) : 0;
+                }
+        };
+
+        /**
+         * @brief Add a member. Members must be added in ascending order.
+         *
+         * @throws std::invalid_argument If index is not above every member.
+         */
+        void add(unsigned long long int index) {
+            if (cardinality > 0 && index <= last)
+                throw std::invalid_argument("AlgorithmBitmap members must be added in ascending order.");
+            /* Once another set shares the segment, it must not change. */
+            if (!building || building.use_count() > 2) {
+                building = std::make_shared<Segment>();
+                segments.push_back(building);
+            }
+            unsigned long long int key = index >> CONTAINER_BITS;
+            std::vector<Container>& containers = building->containers;
+            if (containers.empty() || containers.back().key != key) {
+                containers.emplace_back();
+                containers.back().key = key;
+            }
+            containers.back().add((uint16_t)(index & (CONTAINER_SIZE - 1)));
+            last = index;
+            ++cardinality;
+        }
+
+        /**
+         * @brief Append every member of other, sharing its storage. Every
+         * member of other must be above every member of this set.
+         *
+         * @throws std::invalid_argument If the two sets overlap or are out of
+         * order.
+         */
+        void append(const AlgorithmBitmap& other) {
+            if (other.cardinality == 0)
+                return;
+            if (cardinality > 0 && *other.begin() <= last)
+                throw std::invalid_argument("AlgorithmBitmap can only append members above its own.");
+            segments.insert(segments.end(), other.segments.begin(), other.segments.end());
+            building.reset();
+            cardinality += other.cardinality;
+            last = other.last;
+        }
+
+        unsigned long long int size() const {
+            return cardinality;
+        }
+
+        bool empty() const {
+            return cardinality == 0;
+        }
+
+        bool contains(unsigned long long int index) const {
+            unsigned long long int key = index >> CONTAINER_BITS;
+            uint16_t offset = (uint16_t)(index & (CONTAINER_SIZE - 1));
+            /* Segments are never empty and their keys never decrease, but
+             * neighbouring segments can each hold part of one block. */
+            std::vector<std::shared_ptr<const Segment>>::const_iterator s = std::lower_bound(
+                segments.begin(), segments.end(), key,
+                [](const std::shared_ptr<const Segment>& segment, unsigned long long int k) {
+                    return segment->containers.back().key < k;
+                });
+            for (; s != segments.end() && (*s)->containers.front().key <= key; ++s) {
+                const std::vector<Container>& containers = (*s)->containers;
+                std::vector<Container>::const_iterator c = std::lower_bound(
+                    containers.begin(), containers.end(), key,
+                    [](const Container& container, unsigned long long int k) {
+                        return container.key < k;
+                    });
+                if (c != containers.end() && c->key == key && c->contains(offset))
+                    return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Approximate heap usage of the containers, in bytes.
+         */
+        unsigned long long int getMemoryUsage() const {
+            unsigned long long int bytes = 0;
+            for (const std::shared_ptr<const Segment>& s : segments)
+                for (const Container& c : s->containers)
+                    bytes += sizeof(Container) + c.array.capacity()*sizeof(uint16_t) +
+                             c.bits.capacity()*sizeof(uint64_t);
+            return bytes;
+        }
+
+        const_iterator begin() const {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(this, segments.size());
+        }
+
+        void serialize(std::ostream& out) const {
+            unsigned long long int numContainers = 0;
+            for (const std::shared_ptr<const Segment>& s : segments)
+                numContainers += s->containers.size();
+
+            uint32_t version = VERSION;
+            out.write("ABMP", 4);
+            write(out, version);
+            write(out, cardinality);
+            write(out, numContainers);
+            for (const std::shared_ptr<const Segment>& s : segments) {
+                for (const Container& c : s->containers) {
+                    uint8_t type = c.isBitmap() ? 1 : 0;
+                    write(out, c.key);
+                    write(out, type);
+                    write(out, c.cardinality);
+                    if (c.isBitmap())
+                        out.write((const char*)c.bits.data(), (std::streamsize)(BITMAP_WORDS*sizeof(uint64_t)));
+                    else
+                        out.write((const char*)c.array.data(), (std::streamsize)(c.cardinality*sizeof(uint16_t)));
+                }
+            }
+        }
+
+        /**
+         * @brief Read a set written by serialize.
+         *
+         * @throws std::invalid_argument If the stream does not hold a valid set.
+         */
+        static AlgorithmBitmap deserialize(std::istream& in) {
+            char magic[4];
+            uint32_t version;
+            unsigned long long int size, numContainers;
+            in.read(magic, 4);
+            read(in, version);
+            read(in, size);
+            read(in, numContainers);
+            if (!in || std::string(magic, 4) != "ABMP" || version != VERSION)
+                throw std::invalid_argument("Not a serialized AlgorithmBitmap.");
+
+            AlgorithmBitmap bitmap;
+            std::shared_ptr<Segment> segment;
+            for (unsigned long long int i = 0; i < numContainers; i++) {
+                Container c;
+                uint8_t type;
+                read(in, c.key);
+                read(in, type);
+                read(in, c.cardinality);
+                if (type == 1) {
+                    c.bits.resize(BITMAP_WORDS);
+                    in.read((char*)c.bits.data(), (std::streamsize)(BITMAP_WORDS*sizeof(uint64_t)));
+                } else {
+                    c.array.resize(c.cardinality);
+                    in.read((char*)c.array.data(), (std::streamsize)(c.cardinality*sizeof(uint16_t)));
+                }
+                if (!in || type > 1 || c.cardinality == 0 || c.cardinality > CONTAINER_SIZE || !c.isValid())
+                    throw std::invalid_argument("Truncated or corrupt AlgorithmBitmap.");
+                if (bitmap.cardinality > 0 && c.getFirst() <= bitmap.last)
+                    throw std::invalid_argument("AlgorithmBitmap containers are out of order.");
+
+                /* Neighbouring leaves can both own part of one block. */
+                if (!segment || segment->containers.back().key >= c.key) {
+                    segment = std::make_shared<Segment>();
+                    bitmap.segments.push_back(segment);
+                }
+                bitmap.cardinality += c.cardinality;
+                bitmap.last = c.getLast();
+                segment->containers.push_back(std::move(c));
+            }
+            if (bitmap.cardinality != size)
+                throw std::invalid_argument("Truncated or corrupt AlgorithmBitmap.");
+            return bitmap;
+        }
+
+    private:
+        template<typename T>
+        static void write(std::ostream& out, const T& value) {
+            out.write((const char*)&value, sizeof(T));
+        }
+
+        template<typename T>
+        static void read(std::istream& in, T& value) {
+            in.read((char*)&value, sizeof(T));
+        }
+};
+
+#endif // ALGORITHMBITMAP_H
@@ -0,0 +1,164 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Reads a stream of algorithms in batches. TEXT input is one algorithm per
+ *    line in the setAlgorithm notation; blank lines are skipped. BINARY input
+ *    is a sequence of algorithm numbers, each a u64 in host byte order.
+ *
+ *    The stream is read with read(2) into one buffer that only grows for a
+ *    line longer than any before it. Text lines are copied into the batch as
+ *    NUL terminated strings, so parsing can happen on the worker threads, and
+ *    a batch that is reused does not allocate once it has reached its
+ *    largest size.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "../Algorithm.hpp"
+
+#ifndef ALGORITHMINPUT_H
+#define ALGORITHMINPUT_H
+
+struct InputBatch {
+    unsigned long long int sequence = 0;
+    unsigned long long int firstItem = 0; // Position of the first item in the stream.
+    size_t count = 0;
+    std::string text;                           // TEXT: count NUL terminated lines.
+    std::vector<unsigned long long int> numbers; // BINARY: count algorithm numbers.
+
+    /* Filled in by the worker that evaluates the batch. */
+    unsigned int worker = 0;
+    std::vector<Algorithm> algorithms;
+    std::vector<unsigned int> orders;            // 0 for an invalid item.
+
+    void clear() {
+        count = 0;
+        text.clear();
+        numbers.clear();
+    }
+};
+
+class AlgorithmInput {
+    public:
+        enum Format {
+            TEXT,
+            BINARY
+        };
+
+        static const size_t BUFFER_SIZE = 1 << 20;
+
+        AlgorithmInput(int fd, Format format) :
+            fd(fd), format(format), buffer(BUFFER_SIZE), begin(0), end(0), eof(false), position(0) {}
+
+        /**
+         * @brief Replace the contents of batch with up to maxItems items.
+         *
+         * @return false If the stream had no more items.
+         */
+        bool read(InputBatch& batch, size_t maxItems) {
+            batch.clear();
+            batch.firstItem = position;
+            while (batch.count < maxItems && (format == TEXT ? readLine(batch) : readNumber(batch)))
+                ++batch.count;
+            position += batch.count;
+            return batch.count > 0;
+        }
+
+    private:
+        int fd;
+        Format format;
+        std::vector<char> buffer;
+        size_t begin;
+        size_t end;
+        bool eof;
+        unsigned long long int position;
+
+        bool readLine(InputBatch& batch) {
+            size_t scanned = begin;
+            while (true) {
+                char* newline = (char*)std::memchr(buffer.data() + scanned, '\n', end - scanned);
+                if (newline != nullptr || (eof && end > begin)) {
+                    size_t lineEnd = newline != nullptr ? (size_t)(newline - buffer.data()) : end;
+                    size_t next = newline != nullptr ? lineEnd + 1 : end;
+                    if (lineEnd > begin && buffer[lineEnd - 1] == '\r')
+                        --lineEnd;
+                    if (lineEnd == begin) {
+                        begin = scanned = next;
+                        continue;
+                    }
+                    batch.text.append(buffer.data() + begin, lineEnd - begin);
+                    batch.text += '\0';
+                    begin = next;
+                    return true;
+                }
+                if (eof)
+                    return false;
+                scanned = end;
+                size_t offset = scanned - begin;
+                fill();
+                scanned = begin + offset;
+            }
+        }
+
+        bool readNumber(InputBatch& batch) {
+            while (end - begin < sizeof(unsigned long long int)) {
+                if (eof)
+                    return false;
+                fill();
+            }
+            unsigned long long int number;
+            std::memcpy(&number, buffer.data() + begin, sizeof(number));
+            begin += sizeof(number);
+            batch.numbers.push_back(number);
+            return true;
+        }
+
+        /* Move unread bytes to the front, grow if full, and read more. */
+        void fill() {
+            if (begin > 0) {
+                std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+                end -= begin;
+                begin = 0;
+            }
+            if (end == buffer.size())
+                buffer.resize(buffer.size()*2);
+
+            ssize_t n;
+            do {
+                n = ::read(fd, buffer.data() + end, buffer.size() - end);
+            } while (n < 0 && errno == EINTR);
+            if (n <= 0)
+                eof = true;
+            else
+                end += (size_t)n;
+        }
+};
+
+#endif // ALGORITHMINPUT_H
@@ -22,16 +22,15 @@
  * IN THE SOFTWARE.
  */
 
-#include <vector>
-
 #include "../Algorithm.hpp"
+#include "AlgorithmBitmap.hpp"
 #include "SchwartzGeneratorReduce.hpp"
 
 #ifndef ALGORITHMTALLY_H
 #define ALGORITHMTALLY_H
 
 typedef bool (Algorithm::*RedundancyEvaluator)();
-typedef std::vector<unsigned long long int> AlgorithmList;
+typedef AlgorithmBitmap AlgorithmList;
 
 class AlgorithmTally {
     public:
@@ -44,15 +43,42 @@ class AlgorithmTally {
         }
 };
 
-class Algorithms : public SchwartzGeneratorReduce<AlgorithmTally, AlgorithmList> {
+/**
+ * Evaluates a redundancy check chosen at run time.
+ */
+struct DynamicEvaluator {
+    RedundancyEvaluator re;
+
+    bool operator()(Algorithm& algorithm) const {
+        return (algorithm.*re)();
+    }
+};
+
+/**
+ * Evaluates a redundancy check chosen at compile time, which lets the
+ * compiler inline the check into the leaf loop.
+ */
+template<RedundancyEvaluator RE>
+struct StaticEvaluator {
+    bool operator()(Algorithm& algorithm) const {
+        return (algorithm.*RE)();
+    }
+};
+
+/**
+ * Collects the indices of the algorithms that Evaluator does not consider
+ * redundant. Each leaf walks its slice with ++ on a single algorithm.
+ */
+template<typename Evaluator>
+class AlgorithmReduce : public SchwartzGeneratorReduce<AlgorithmTally, AlgorithmList> {
     public:
-        Algorithms(size_t n_threads, unsigned long long int dataSize, RedundancyEvaluator re) : 
-            SchwartzGeneratorReduce<AlgorithmTally, AlgorithmList>(n_threads, dataSize) {
-            this->re = re;
-        } 
+        AlgorithmReduce(size_t n_threads, unsigned long long int dataSize,
+                        Evaluator evaluator = Evaluator(), ThreadPool* pool = nullptr) :
+            SchwartzGeneratorReduce<AlgorithmTally, AlgorithmList>(n_threads, dataSize, pool),
+            evaluator(evaluator) {}
 
     private:
-        RedundancyEvaluator re;
+        Evaluator evaluator;
 
     protected:
         virtual AlgorithmTally* init() const {
@@ -60,9 +86,10 @@ class Algorithms : public SchwartzGeneratorReduce<AlgorithmTally, AlgorithmList>
         }
 
         virtual AlgorithmTally* combine(const AlgorithmTally* left, const AlgorithmTally* right) const {
+            /* Leaf slices are disjoint and in order, so this shares rather than copies. */
             AlgorithmTally* at = init();
-            at->algorithms->insert(at->algorithms->end(), left->algorithms->begin(), left->algorithms->end());
-            at->algorithms->insert(at->algorithms->end(), right->algorithms->begin(), right->algorithms->end());
+            at->algorithms->append(*(left->algorithms));
+            at->algorithms->append(*(right->algorithms));
             return at;
         }
 
@@ -73,9 +100,27 @@ class Algorithms : public SchwartzGeneratorReduce<AlgorithmTally, AlgorithmList>
         virtual void accum(AlgorithmTally* accumulator, unsigned long long int index) const {
             unsigned long long int x = accumulator->algorithm->getAlgorithmNumber();
             *(accumulator->algorithm) += (index - x);
-            if (!(*(accumulator->algorithm).*re)())
-                accumulator->algorithms->push_back(index);
+            if (!evaluator(*(accumulator->algorithm)))
+                accumulator->algorithms->add(index);
+        }
+
+        virtual void accumRange(AlgorithmTally* accumulator, unsigned long long int start,
+                                unsigned long long int end) const {
+            Algorithm& algorithm = *(accumulator->algorithm);
+            algorithm += (start - algorithm.getAlgorithmNumber());
+            for (unsigned long long int j = start; j < end; ++j, ++algorithm)
+                if (!evaluator(algorithm))
+                    accumulator->algorithms->add(j);
         }
 };
 
-#endif // ALGORITHMTALLY_H
\ No newline at end of file
+template<RedundancyEvaluator RE>
+using StaticAlgorithms = AlgorithmReduce<StaticEvaluator<RE>>;
+
+class Algorithms : public AlgorithmReduce<DynamicEvaluator> {
+    public:
+        Algorithms(size_t n_threads, unsigned long long int dataSize, RedundancyEvaluator re, ThreadPool* pool = nullptr) : 
+            AlgorithmReduce<DynamicEvaluator>(n_threads, dataSize, DynamicEvaluator{re}, pool) {}
+};
+
+#endif // ALGORITHMTALLY_H
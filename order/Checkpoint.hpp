@@ -0,0 +1,338 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Progress of a long search, so that it can be resumed after it is stopped
+ *    or crashes.
+ *
+ *    ChunkSet records which RangeScheduler chunks are complete, one atomic bit
+ *    per chunk. Chunks are dealt round robin and stolen, so completion is not
+ *    a single prefix. A Checkpoint stores it as a watermark, below which every
+ *    chunk is complete, plus the few complete chunks above the watermark.
+ *
+ *    A Checkpoint also holds the orders already written, the lowest algorithm
+ *    found so far for orders not yet written, and the histogram counts of
+ *    the complete chunks. It is a small text file, written to a
+ *    temporary file and renamed over the old one, so a crash while saving
+ *    leaves the previous checkpoint intact.
+ *
+ *    Checkpointer saves a snapshot every interval from its own thread. The
+ *    snapshot function decides what is consistent; the workers never wait on
+ *    the file system.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "OrderHistogram.hpp"
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+class ChunkSet {
+    public:
+        ChunkSet(unsigned long long int numChunks) :
+                 numChunks(numChunks), numWords((size_t)((numChunks + 63) / 64)),
+                 words(new std::atomic<uint64_t>[numWords]), firstOpenWord(0) {
+            for (size_t i = 0; i < numWords; i++)
+                words[i].store(0, std::memory_order_relaxed);
+        }
+
+        ChunkSet(const ChunkSet&) = delete;
+        ChunkSet& operator=(const ChunkSet&) = delete;
+
+        void mark(unsigned long long int chunk) {
+            if (chunk < numChunks)
+                words[chunk / 64].fetch_or(getBit(chunk), std::memory_order_release);
+        }
+
+        bool isMarked(unsigned long long int chunk) const {
+            if (chunk >= numChunks)
+                return false;
+            return words[chunk / 64].load(std::memory_order_relaxed) & getBit(chunk);
+        }
+
+        /**
+         * @brief The first chunk that is not complete, or numChunks if every
+         * chunk is. Whatever was done before marking the chunks below it is
+         * visible to the caller.
+         */
+        unsigned long long int getWatermark() const {
+            /* Words only fill up, so the scan resumes where the last one stopped. */
+            for (size_t i = firstOpenWord.load(std::memory_order_acquire); i < numWords; i++) {
+                uint64_t word = words[i].load(std::memory_order_acquire);
+                if (word != ~0ULL) {
+                    firstOpenWord.store(i, std::memory_order_release);
+                    unsigned long long int chunk = i*64ULL + (unsigned long long int)__builtin_ctzll(~word);
+                    return chunk < numChunks ? chunk : numChunks;
+                }
+            }
+            return numChunks;
+        }
+
+        /**
+         * @brief The complete chunks above watermark, in ascending order.
+         */
+        std::vector<unsigned long long int> getMarkedAbove(unsigned long long int watermark) const {
+            std::vector<unsigned long long int> marked;
+            for (unsigned long long int chunk = watermark + 1; chunk < numChunks; chunk++)
+                if (isMarked(chunk))
+                    marked.push_back(chunk);
+            return marked;
+        }
+
+        unsigned long long int getNumChunks() const {
+            return numChunks;
+        }
+
+    private:
+        unsigned long long int numChunks;
+        size_t numWords;
+        std::unique_ptr<std::atomic<uint64_t>[]> words;
+        mutable std::atomic<size_t> firstOpenWord;
+
+        static uint64_t getBit(unsigned long long int chunk) {
+            return 1ULL << (chunk % 64);
+        }
+};
+
+class Checkpoint {
+    public:
+        static const unsigned int VERSION = 1;
+
+        std::string startAlgorithm;
+        unsigned long long int count = 0;
+        unsigned long long int chunkSize = 0;
+        std::string shard = "0/1"; // Chunks count from the start of the shard.
+        unsigned long long int watermark = 0;
+        std::vector<unsigned long long int> completed; // Complete chunks above watermark.
+        std::vector<unsigned int> found;
+        std::vector<std::pair<unsigned int, unsigned long long int>> best; // Order, algorithm number.
+        OrderHistogram histogram;
+
+        Checkpoint(size_t numOrders) : histogram(numOrders) {}
+
+        /**
+         * @brief Replace the file at path with this checkpoint.
+         *
+         * @throws std::runtime_error If the file cannot be written.
+         */
+        void save(const std::string& path) const {
+            std::ostringstream out;
+            out << "cube-checkpoint " << VERSION << "\n"
+                << "start " << startAlgorithm << "\n"
+                << "count " << count << "\n"
+                << "chunk-size " << chunkSize << "\n"
+                << "shard " << shard << "\n"
+                << "watermark " << watermark << "\n"
+                << "completed " << completed.size();
+            for (unsigned long long int chunk : completed)
+                out << " " << chunk;
+            out << "\nfound " << found.size();
+            for (unsigned int order : found)
+                out << " " << order;
+            out << "\nbest " << best.size();
+            for (const std::pair<unsigned int, unsigned long long int>& b : best)
+                out << " " << b.first << " " << b.second;
+            out << "\n";
+
+            std::ostringstream counts;
+            size_t numCounts = 0;
+            for (size_t length = 0; length < histogram.getLengths(); length++) {
+                for (size_t order = 0; order < histogram.getNumOrders(); order++) {
+                    unsigned long long int n = histogram.get(order, length);
+                    if (n == 0)
+                        continue;
+                    counts << order << " " << length << " " << n << "\n";
+                    ++numCounts;
+                }
+            }
+            out << "histogram " << numCounts << "\n" << counts.str();
+
+            std::string tmpPath = path + ".tmp";
+            std::string data = out.str();
+            int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0)
+                throw std::runtime_error("Unable to write checkpoint " + tmpPath);
+            const char* p = data.data();
+            size_t remaining = data.size();
+            while (remaining > 0) {
+                ssize_t written = ::write(fd, p, remaining);
+                if (written <= 0) {
+                    ::close(fd);
+                    throw std::runtime_error("Unable to write checkpoint " + tmpPath);
+                }
+                p += written;
+                remaining -= (size_t)written;
+            }
+            if (::fsync(fd) != 0 || ::close(fd) != 0 ||
+                std::rename(tmpPath.c_str(), path.c_str()) != 0)
+                throw std::runtime_error("Unable to write checkpoint " + path);
+        }
+
+        /**
+         * @brief Read the checkpoint at path.
+         *
+         * @throws std::runtime_error If the file is missing or malformed.
+         */
+        void load(const std::string& path) {
+            std::ifstream in(path);
+            if (!in)
+                throw std::runtime_error("Unable to open checkpoint " + path);
+
+            std::string key;
+            unsigned int version = 0;
+            if (!(in >> key >> version) || key != "cube-checkpoint" || version != VERSION)
+                throw std::runtime_error("Not a checkpoint: " + path);
+
+            in >> key;
+            std::getline(in, startAlgorithm);
+            if (!startAlgorithm.empty() && startAlgorithm[0] == ' ')
+                startAlgorithm.erase(0, 1);
+            expect(in, key, "start", path);
+
+            in >> key >> count;
+            expect(in, key, "count", path);
+            in >> key >> chunkSize;
+            expect(in, key, "chunk-size", path);
+            in >> key >> shard;
+            expect(in, key, "shard", path);
+            in >> key >> watermark;
+            expect(in, key, "watermark", path);
+
+            size_t n = 0;
+            in >> key >> n;
+            expect(in, key, "completed", path);
+            completed.resize(n);
+            for (unsigned long long int& chunk : completed)
+                in >> chunk;
+
+            in >> key >> n;
+            expect(in, key, "found", path);
+            found.resize(n);
+            for (unsigned int& order : found)
+                in >> order;
+
+            in >> key >> n;
+            expect(in, key, "best", path);
+            best.resize(n);
+            for (std::pair<unsigned int, unsigned long long int>& b : best)
+                in >> b.first >> b.second;
+
+            in >> key >> n;
+            expect(in, key, "histogram", path);
+            histogram = OrderHistogram(histogram.getNumOrders());
+            for (size_t i = 0; i < n; i++) {
+                size_t order, length;
+                unsigned long long int c;
+                in >> order >> length >> c;
+                histogram.add(order, length, c);
+            }
+            if (!in)
+                throw std::runtime_error("Truncated checkpoint " + path);
+        }
+
+    private:
+        static void expect(const std::istream& in, const std::string& key,
+                           const char* wanted, const std::string& path) {
+            if (!in || key != wanted)
+                throw std::runtime_error("Malformed checkpoint " + path + ": expected " + wanted);
+        }
+};
+
+class Checkpointer {
+    public:
+        /**
+         * @param snapshot Called from the checkpoint thread to build each
+         * checkpoint.
+         */
+        Checkpointer(const std::string& path, unsigned long long int intervalSeconds,
+                     std::function<Checkpoint()> snapshot) :
+                     path(path), interval(intervalSeconds < 1 ? 1 : intervalSeconds),
+                     snapshot(snapshot), stopping(false) {
+            thread = std::thread(&Checkpointer::run, this);
+        }
+
+        Checkpointer(const Checkpointer&) = delete;
+        Checkpointer& operator=(const Checkpointer&) = delete;
+
+        ~Checkpointer() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            thread.join();
+        }
+
+        /**
+         * @brief Save a checkpoint now. Failures are reported on stderr and
+         * the search carries on.
+         */
+        void save() {
+            std::lock_guard<std::mutex> lock(saveMutex);
+            try {
+                snapshot().save(path);
+            } catch (const std::runtime_error& e) {
+                std::fprintf(stderr, "%s\n", e.what());
+            }
+        }
+
+    private:
+        std::string path;
+        std::chrono::seconds interval;
+        std::function<Checkpoint()> snapshot;
+        std::mutex saveMutex;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping;
+        std::thread thread;
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, interval, [this] { return stopping; })) {
+                lock.unlock();
+                save();
+                lock.lock();
+            }
+        }
+};
+
+#endif // CHECKPOINT_H
@@ -0,0 +1,370 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    The set of orders that --find-orders style searches still need to find.
+ *    Every order is one bit in an array of atomic words, and a bit that is set
+ *    means the order has been found, or was never wanted.
+ *
+ *    Checking an order is a single relaxed load. Claiming a newly found order
+ *    is a fetch_or, so exactly one thread wins each order without a lock. The
+ *    thread that claims the last wanted order raises a stop flag that every
+ *    worker polls between algorithms.
+ *
+ *    The lowest algorithm number claimed for each order is kept with an
+ *    atomic minimum, so a search can report the lowest algorithm of each
+ *    order no matter which thread got there first. Once every wanted order
+ *    has been found, getBound says how far the search still has to go to
+ *    be sure of those minimums. Whoever reports an order marks it reported,
+ *    which happens once per process.
+ *
+ *    markWanted and the constructor are for setup, before any worker starts.
+ *
+ *    share moves the state into a file mapped with MAP_SHARED, so that
+ *    separate processes searching for the same orders skip each other's finds
+ *    and stop together. The first process creates the file. Later ones check
+ *    that they want the same orders and pick up whatever has been found:
+ *
+ *       header: "CUBEFND\0" <u32 version> <u32 orders> <u64 size>
+ *       <u64 words> the orders never wanted, as the creator set them up
+ *       <u64 words> found bits
+ *       <u64> wanted orders not yet found
+ *       <u64> stop flag
+ *       <u64 per order> lowest algorithm number found, or NO_ALGORITHM
+ *
+ *    The words are host order, and the file only works between processes on
+ *    one machine. The lowest number this process claimed for each order and
+ *    the reported marks stay private to the process, so a process only
+ *    reports orders whose lowest algorithm it found itself.
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifndef FOUNDORDERS_H
+#define FOUNDORDERS_H
+
+class FoundOrders {
+    public:
+        static constexpr uint64_t NO_ALGORITHM = ~0ULL;
+
+        /**
+         * @param numOrders Orders 0 through numOrders - 1 are tracked.
+         * @param found Initial state of every order. If false, every order is
+         * wanted.
+         */
+        FoundOrders(size_t numOrders, bool found) :
+                    numOrders(numOrders), numWords((numOrders + 63) / 64),
+                    size(getSize(numOrders)), mapped(nullptr),
+                    own(new std::atomic<uint64_t>[numOrders]),
+                    reported(new std::atomic<uint64_t>[numWords]) {
+            local.reset(new uint64_t[size / sizeof(uint64_t)]);
+            init(local.get());
+            for (size_t i = 0; i < numWords; i++) {
+                unwanted[i] = (found ? ~0ULL : 0) | getPadding(i);
+                words[i].store(found ? ~0ULL : 0, std::memory_order_relaxed);
+                reported[i].store(0, std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < numOrders; i++)
+                own[i].store(NO_ALGORITHM, std::memory_order_relaxed);
+            remaining->store(found ? 0 : numOrders, std::memory_order_relaxed);
+            stopped->store(found ? 1 : 0, std::memory_order_relaxed);
+        }
+
+        FoundOrders(const FoundOrders&) = delete;
+        FoundOrders& operator=(const FoundOrders&) = delete;
+
+        ~FoundOrders() {
+            if (mapped != nullptr)
+                munmap(mapped, size);
+        }
+
+        /**
+         * @brief Add an order to the search. Out of range orders are ignored.
+         */
+        void markWanted(size_t order) {
+            if (order >= numOrders || !isFound(order))
+                return;
+            words[order / 64].fetch_and(~getBit(order), std::memory_order_relaxed);
+            unwanted[order / 64] &= ~getBit(order);
+            remaining->fetch_add(1, std::memory_order_relaxed);
+            stopped->store(0, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Share the state through the file at path, creating it if it
+         * does not exist. Call once, after setup and before any worker starts.
+         *
+         * @throws std::runtime_error If the file cannot be used, or was created
+         * for a different set of orders.
+         */
+        void share(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDWR);
+            if (fd < 0 && errno == ENOENT)
+                fd = create(path);
+            if (fd < 0)
+                throw std::runtime_error("Cannot open " + path + ".");
+
+            struct stat st;
+            void* map = MAP_FAILED;
+            if (fstat(fd, &st) == 0 && (size_t)st.st_size == size)
+                map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (map == MAP_FAILED)
+                throw std::runtime_error(path + " is not a found orders file for " +
+                                         std::to_string(numOrders) + " orders.");
+
+            const Header* header = (const Header*)map;
+            const uint64_t* unwanted = (const uint64_t*)((const char*)map + sizeof(Header));
+            bool same = std::memcmp(header->magic, MAGIC, sizeof(header->magic)) == 0 &&
+                        header->version == VERSION && header->numOrders == numOrders;
+            for (size_t i = 0; same && i < numWords; i++)
+                same = unwanted[i] == this->unwanted[i];
+            if (!same) {
+                munmap(map, size);
+                throw std::runtime_error(path + " was created for a different set of orders.");
+            }
+
+            mapped = map;
+            attach((char*)map);
+            local.reset();
+        }
+
+        bool isWanted(size_t order) const {
+            return order < numOrders && !(unwanted[order / 64] & getBit(order));
+        }
+
+        bool isFound(size_t order) const {
+            if (order >= numOrders)
+                return true;
+            return words[order / 64].load(std::memory_order_relaxed) & getBit(order);
+        }
+
+        /**
+         * @brief Mark an order found.
+         *
+         * @param algNum The absolute number of the algorithm that has it, kept
+         * if it is the lowest so far.
+         * @return true If this call found the order first, or algNum is the
+         * lowest this process has claimed for it.
+         */
+        bool claim(size_t order, uint64_t algNum = NO_ALGORITHM) {
+            if (order >= numOrders)
+                return false;
+            bool lowest = false;
+            if (algNum != NO_ALGORITHM) {
+                lowerTo(best[order], algNum);
+                lowest = lowerTo(own[order], algNum);
+            }
+
+            /* The minimum is published before the bit, so a found order always has one. */
+            uint64_t bit = getBit(order);
+            bool first = !(words[order / 64].fetch_or(bit, std::memory_order_acq_rel) & bit);
+            if (first && remaining->fetch_sub(1, std::memory_order_acq_rel) == 1)
+                stopped->store(1, std::memory_order_release);
+            return first || lowest;
+        }
+
+        /**
+         * @brief Mark an order reported, which also counts it as found.
+         *
+         * @return true If this call reported it first.
+         */
+        bool report(size_t order) {
+            if (order >= numOrders)
+                return false;
+            uint64_t bit = getBit(order);
+            bool first = !(reported[order / 64].fetch_or(bit, std::memory_order_acq_rel) & bit);
+            claim(order);
+            return first;
+        }
+
+        bool isReported(size_t order) const {
+            if (order >= numOrders)
+                return true;
+            return reported[order / 64].load(std::memory_order_acquire) & getBit(order);
+        }
+
+        /**
+         * @brief True once every wanted order has been found.
+         */
+        bool done() const {
+            return stopped->load(std::memory_order_acquire) != 0;
+        }
+
+        unsigned long long int getRemaining() const {
+            return remaining->load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief The lowest algorithm number claimed for an order, or
+         * NO_ALGORITHM.
+         */
+        uint64_t getBest(size_t order) const {
+            if (order >= numOrders)
+                return NO_ALGORITHM;
+            return best[order].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief The lowest algorithm number this process claimed for an
+         * order, or NO_ALGORITHM.
+         */
+        uint64_t getOwnBest(size_t order) const {
+            if (order >= numOrders)
+                return NO_ALGORITHM;
+            return own[order].load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Algorithms numbered above the bound cannot lower the minimum
+         * of any wanted order that is not yet reported. NO_ALGORITHM until
+         * every wanted order has been found.
+         */
+        uint64_t getBound() const {
+            if (!done())
+                return NO_ALGORITHM;
+            uint64_t bound = 0;
+            for (size_t order = 0; order < numOrders; order++) {
+                if (!isWanted(order) || isReported(order))
+                    continue;
+                uint64_t algNum = best[order].load(std::memory_order_relaxed);
+                bound = algNum > bound ? algNum : bound;
+            }
+            return bound;
+        }
+
+    private:
+        static constexpr const char* MAGIC = "CUBEFND";
+        static constexpr uint32_t VERSION = 1;
+
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t numOrders;
+            uint64_t size;
+        };
+
+        size_t numOrders;
+        size_t numWords;
+        size_t size;
+        void* mapped;
+        std::unique_ptr<uint64_t[]> local;
+        uint64_t* unwanted;
+        std::atomic<uint64_t>* words;
+        std::atomic<uint64_t>* remaining;
+        std::atomic<uint64_t>* stopped;
+        std::atomic<uint64_t>* best;
+        std::unique_ptr<std::atomic<uint64_t>[]> own;
+        std::unique_ptr<std::atomic<uint64_t>[]> reported;
+
+        /* Atomic minimum. True if value is now the minimum. */
+        static bool lowerTo(std::atomic<uint64_t>& minimum, uint64_t value) {
+            uint64_t current = minimum.load(std::memory_order_relaxed);
+            while (value < current &&
+                   !minimum.compare_exchange_weak(current, value, std::memory_order_relaxed));
+            return value <= current;
+        }
+
+        static size_t getSize(size_t numOrders) {
+            size_t numWords = (numOrders + 63) / 64;
+            return sizeof(Header) + (2*numWords + 2 + numOrders)*sizeof(uint64_t);
+        }
+
+        /* Bits past the last order, which are always set in the found words. */
+        uint64_t getPadding(size_t word) const {
+            if (word + 1 < numWords || numOrders % 64 == 0)
+                return 0;
+            return ~0ULL << (numOrders % 64);
+        }
+
+        void attach(char* base) {
+            uint64_t* p = (uint64_t*)(base + sizeof(Header));
+            unwanted = p;
+            words = (std::atomic<uint64_t>*)(p + numWords);
+            remaining = (std::atomic<uint64_t>*)(p + 2*numWords);
+            stopped = remaining + 1;
+            best = stopped + 1;
+        }
+
+        void init(void* base) {
+            std::memset(base, 0, size);
+            Header* header = (Header*)base;
+            std::memcpy(header->magic, MAGIC, sizeof(header->magic));
+            header->version = VERSION;
+            header->numOrders = (uint32_t)numOrders;
+            header->size = size;
+            attach((char*)base);
+            for (size_t i = 0; i < numWords; i++)
+                new (&words[i]) std::atomic<uint64_t>(0);
+            new (remaining) std::atomic<uint64_t>(0);
+            new (stopped) std::atomic<uint64_t>(0);
+            for (size_t i = 0; i < numOrders; i++)
+                new (&best[i]) std::atomic<uint64_t>(NO_ALGORITHM);
+        }
+
+        /**
+         * Write a copy of the current state to a temporary file and link it
+         * into place, so other processes never see a half written file.
+         */
+        int create(const std::string& path) {
+            std::string tmpPath = path + ".tmp." + std::to_string(getpid());
+            int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+            if (fd < 0)
+                return -1;
+            const char* data = (const char*)local.get();
+            bool written = true;
+            for (size_t done = 0; written && done < size;) {
+                ssize_t n = ::write(fd, data + done, size - done);
+                written = n > 0;
+                done += written ? (size_t)n : 0;
+            }
+            ::close(fd);
+
+            /* link fails if another process created the file first; use theirs. */
+            if (!written || (::link(tmpPath.c_str(), path.c_str()) != 0 && errno != EEXIST)) {
+                ::unlink(tmpPath.c_str());
+                return -1;
+            }
+            ::unlink(tmpPath.c_str());
+            return ::open(path.c_str(), O_RDWR);
+        }
+
+        static uint64_t getBit(size_t order) {
+            return 1ULL << (order % 64);
+        }
+};
+
+#endif // FOUNDORDERS_H
@@ -0,0 +1,251 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Progress reporting for long searches. Each search thread counts its work
+ *    in its own ThreadCounters. Only that thread writes its counters, so an
+ *    update is a relaxed load and store with no locked instruction. The
+ *    counters sit on separate cache lines.
+ *
+ *    A Monitor thread samples the counters every interval. It prints the
+ *    throughput and an ETA to stderr, and replaces a metrics file in the
+ *    Prometheus text format, written to a temporary file and renamed like a
+ *    checkpoint. SIGUSR1 asks for the same snapshot at once. The handler only
+ *    sets a flag, which the monitor polls every POLL_MS.
+ *
+ *    Only one Monitor may exist at a time, since it owns the SIGUSR1 handler.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <fcntl.h>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+struct alignas(64) ThreadCounters {
+    std::atomic<uint64_t> enumerated{0}; // Algorithms walked.
+    std::atomic<uint64_t> redundant{0};  // Rejected as redundant.
+    std::atomic<uint64_t> evaluated{0};  // Orders found, computed or looked up.
+    std::atomic<uint64_t> turns{0};      // Turns applied to compute orders.
+
+    /* For the owning thread only. */
+    static void add(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+class Monitor {
+    public:
+        static constexpr unsigned int POLL_MS = 100;
+
+        /**
+         * @param counters One per search thread, outliving the monitor.
+         * @param total Algorithms the whole search covers.
+         * @param done Algorithms already searched before this run, e.g. by a
+         * resumed checkpoint.
+         * @param intervalSeconds How often to report. Zero reports only on
+         * SIGUSR1.
+         * @param metricsPath The metrics file, or empty for none.
+         */
+        Monitor(const std::vector<ThreadCounters*>& counters, uint64_t total, uint64_t done,
+                unsigned long long int intervalSeconds, const std::string& metricsPath) :
+                counters(counters), total(total), done(done),
+                interval(intervalSeconds), metricsPath(metricsPath), stopping(false) {
+            start = std::chrono::steady_clock::now();
+            last = {start, 0};
+            struct sigaction action = {};
+            action.sa_handler = request;
+            sigemptyset(&action.sa_mask);
+            action.sa_flags = SA_RESTART;
+            sigaction(SIGUSR1, &action, &previous);
+            thread = std::thread(&Monitor::run, this);
+        }
+
+        Monitor(const Monitor&) = delete;
+        Monitor& operator=(const Monitor&) = delete;
+
+        ~Monitor() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            thread.join();
+            sigaction(SIGUSR1, &previous, nullptr);
+        }
+
+    private:
+        struct Sample {
+            std::chrono::steady_clock::time_point time;
+            uint64_t enumerated;
+        };
+
+        static inline volatile std::sig_atomic_t requested = 0;
+
+        std::vector<ThreadCounters*> counters;
+        uint64_t total;
+        uint64_t done;
+        std::chrono::seconds interval;
+        std::string metricsPath;
+        std::chrono::steady_clock::time_point start;
+        Sample last;
+        struct sigaction previous;
+        std::mutex mutex;
+        std::condition_variable wake;
+        bool stopping;
+        std::thread thread;
+
+        static void request(int) {
+            requested = 1;
+        }
+
+        void run() {
+            auto next = start + interval;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, std::chrono::milliseconds(POLL_MS), [this] { return stopping; })) {
+                auto now = std::chrono::steady_clock::now();
+                bool due = interval.count() > 0 && now >= next;
+                if (!due && !requested)
+                    continue;
+                requested = 0;
+                if (due)
+                    next = now + interval;
+                lock.unlock();
+                report(now);
+                lock.lock();
+            }
+        }
+
+        void report(std::chrono::steady_clock::time_point now) {
+            uint64_t enumerated = 0, redundant = 0, evaluated = 0, turns = 0;
+            for (ThreadCounters* c : counters) {
+                enumerated += c->enumerated.load(std::memory_order_relaxed);
+                redundant += c->redundant.load(std::memory_order_relaxed);
+                evaluated += c->evaluated.load(std::memory_order_relaxed);
+                turns += c->turns.load(std::memory_order_relaxed);
+            }
+
+            /* The rate is over the last report, the ETA assumes it holds. */
+            double elapsed = std::chrono::duration<double>(now - start).count();
+            double span = std::chrono::duration<double>(now - last.time).count();
+            double rate = span > 0 ? (double)(enumerated - last.enumerated) / span : 0;
+            last = {now, enumerated};
+            uint64_t searched = done + enumerated;
+            uint64_t remaining = total > searched ? total - searched : 0;
+            double eta = rate > 0 ? (double)remaining / rate : -1;
+
+            char line[256];
+            std::snprintf(line, sizeof(line),
+                          "PR:%llu RATE:%.0f/s DONE:%.2f%% ETA:%s RD:%llu EV:%llu TU:%llu\n",
+                          (unsigned long long)searched, rate,
+                          total > 0 ? 100.0*(double)searched/(double)total : 100.0,
+                          formatDuration(eta).c_str(), (unsigned long long)redundant,
+                          (unsigned long long)evaluated, (unsigned long long)turns);
+            std::fputs(line, stderr);
+
+            if (metricsPath.empty())
+                return;
+            try {
+                writeMetrics(elapsed, rate, remaining, eta);
+            } catch (const std::runtime_error& e) {
+                std::fprintf(stderr, "%s\n", e.what());
+            }
+        }
+
+        void writeMetrics(double elapsed, double rate, uint64_t remaining, double eta) const {
+            std::ostringstream out;
+            counter(out, "cube_algorithms_enumerated_total", "Algorithms walked by the search.",
+                    &ThreadCounters::enumerated);
+            counter(out, "cube_algorithms_redundant_total", "Algorithms rejected as redundant.",
+                    &ThreadCounters::redundant);
+            counter(out, "cube_orders_evaluated_total", "Orders computed or looked up.",
+                    &ThreadCounters::evaluated);
+            counter(out, "cube_turns_applied_total", "Turns applied to compute orders.",
+                    &ThreadCounters::turns);
+            gauge(out, "cube_search_elapsed_seconds", "Time since the search started.", elapsed);
+            gauge(out, "cube_search_rate", "Algorithms walked per second since the last report.", rate);
+            gauge(out, "cube_search_remaining_algorithms", "Algorithms left to walk.", (double)remaining);
+            gauge(out, "cube_search_eta_seconds", "Estimated time left, or -1 if unknown.", eta);
+
+            std::string tmpPath = metricsPath + ".tmp";
+            std::string data = out.str();
+            int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (fd < 0)
+                throw std::runtime_error("Unable to write metrics " + tmpPath);
+            const char* p = data.data();
+            size_t left = data.size();
+            while (left > 0) {
+                ssize_t written = ::write(fd, p, left);
+                if (written <= 0) {
+                    ::close(fd);
+                    throw std::runtime_error("Unable to write metrics " + tmpPath);
+                }
+                p += written;
+                left -= (size_t)written;
+            }
+            if (::close(fd) != 0 || std::rename(tmpPath.c_str(), metricsPath.c_str()) != 0)
+                throw std::runtime_error("Unable to write metrics " + metricsPath);
+        }
+
+        void counter(std::ostringstream& out, const char* name, const char* help,
+                     std::atomic<uint64_t> ThreadCounters::*field) const {
+            out << "# HELP " << name << " " << help << "\n"
+                << "# TYPE " << name << " counter\n";
+            for (size_t i = 0; i < counters.size(); i++)
+                out << name << "{thread=\"" << i << "\"} "
+                    << (counters[i]->*field).load(std::memory_order_relaxed) << "\n";
+        }
+
+        static void gauge(std::ostringstream& out, const char* name, const char* help, double value) {
+            out << "# HELP " << name << " " << help << "\n"
+                << "# TYPE " << name << " gauge\n"
+                << name << " " << std::fixed << value << "\n";
+            out.unsetf(std::ios::floatfield);
+        }
+
+        /* h:mm:ss, or "?" when unknown. */
+        static std::string formatDuration(double seconds) {
+            if (seconds < 0)
+                return "?";
+            unsigned long long int s = (unsigned long long int)seconds;
+            char text[64];
+            std::snprintf(text, sizeof(text), "%llu:%02llu:%02llu", s / 3600, s / 60 % 60, s % 60);
+            return text;
+        }
+};
+
+#endif // MONITOR_H
@@ -0,0 +1,129 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    A bounded multiple producer, multiple consumer queue. Any thread may push
+ *    or pop without taking a lock. Each slot carries a sequence number that
+ *    says whether it is ready to be written or read on the current lap, so a
+ *    push or pop is one compare and swap on the shared position plus one
+ *    store to the slot.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+
+template<typename T>
+class MpmcQueue {
+    public:
+        /**
+         * @param capacity Rounded up to a power of two.
+         */
+        MpmcQueue(size_t capacity) : head(0), tail(0) {
+            size = 1;
+            while (size < capacity)
+                size <<= 1;
+            slots.reset(new Slot[size]);
+            for (size_t i = 0; i < size; i++)
+                slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        MpmcQueue(const MpmcQueue&) = delete;
+        MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+        /**
+         * @return false If the queue is full.
+         */
+        bool tryPush(const T& item) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = slots[t & (size - 1)];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence == t) {
+                    if (tail.compare_exchange_weak(t, t + 1, std::memory_order_relaxed)) {
+                        slot.item = item;
+                        slot.sequence.store(t + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (sequence < t) {
+                    return false;
+                } else {
+                    t = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @return false If the queue is empty.
+         */
+        bool tryPop(T& item) {
+            size_t h = head.load(std::memory_order_relaxed);
+            while (true) {
+                Slot& slot = slots[h & (size - 1)];
+                size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                if (sequence == h + 1) {
+                    if (head.compare_exchange_weak(h, h + 1, std::memory_order_relaxed)) {
+                        item = slot.item;
+                        slot.sequence.store(h + size, std::memory_order_release);
+                        return true;
+                    }
+                } else if (sequence < h + 1) {
+                    return false;
+                } else {
+                    h = head.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        /**
+         * @brief The number of items queued. Only a hint while other threads
+         * push or pop.
+         */
+        size_t sizeApprox() const {
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t h = head.load(std::memory_order_relaxed);
+            return t > h ? t - h : 0;
+        }
+
+        size_t capacity() const {
+            return size;
+        }
+
+    private:
+        struct Slot {
+            std::atomic<size_t> sequence;
+            T item;
+        };
+
+        alignas(64) std::atomic<size_t> head;
+        alignas(64) std::atomic<size_t> tail;
+        alignas(64) size_t size;
+        std::unique_ptr<Slot[]> slots;
+};
+
+#endif // MPMCQUEUE_H
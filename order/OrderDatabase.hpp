@@ -0,0 +1,322 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    A table of the order of every non-redundant algorithm up to a given
+ *    length, stored in a file that is memory mapped on load. Nothing is read
+ *    until a lookup touches it, so opening even a large table is fast.
+ *
+ *    Algorithms of up to maxLength turns are algorithm numbers 0 through
+ *    getNumAlgorithms(maxLength) - 1. The file holds:
+ *
+ *       header     counts and sizes, HEADER_SIZE bytes
+ *       bitmap     one bit per algorithm number, set if it has an entry
+ *       directory  for every SUPERBLOCK_WORDS bitmap words, the number of
+ *                  set bits before them
+ *       orders     BITS_PER_ORDER bit entries, packed, in algorithm number
+ *                  order
+ *
+ *    A lookup checks the bitmap, then finds the entry's rank from the
+ *    directory and at most SUPERBLOCK_WORDS popcounts, so every lookup is
+ *    O(1). Integers are in host byte order.
+ *
+ *    Only the classic alphabet (layer depth one) and the 3x3x3 cube are
+ *    covered, matching the CLI.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../Algorithm.hpp"
+#include "../Cube.hpp"
+#include "AlgorithmTally.hpp"
+#include "RangeScheduler.hpp"
+
+#ifndef ORDERDATABASE_H
+#define ORDERDATABASE_H
+
+class OrderDatabase {
+    public:
+        static const unsigned int BITS_PER_ORDER = 11;
+        static const unsigned int SUPERBLOCK_WORDS = 8;
+        static const uint32_t VERSION = 1;
+
+        /**
+         * @throws std::runtime_error If the file cannot be mapped or is not an
+         * order database.
+         */
+        OrderDatabase(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Cannot open " + path + ".");
+            struct stat st;
+            if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(Header)) {
+                ::close(fd);
+                throw std::runtime_error(path + " is not an order database.");
+            }
+            length = (size_t)st.st_size;
+            map = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (map == MAP_FAILED)
+                throw std::runtime_error("Cannot map " + path + ".");
+
+            header = (const Header*)map;
+            if (std::memcmp(header->magic, getMagic(), sizeof(header->magic)) != 0 ||
+                header->version != VERSION || length != getFileSize(*header)) {
+                munmap(map, length);
+                throw std::runtime_error(path + " is not an order database.");
+            }
+            bitmap = (const uint64_t*)((const char*)map + sizeof(Header));
+            directory = bitmap + header->bitmapWords;
+            orders = directory + header->directoryEntries;
+        }
+
+        OrderDatabase(const OrderDatabase&) = delete;
+        OrderDatabase& operator=(const OrderDatabase&) = delete;
+
+        ~OrderDatabase() {
+            munmap(map, length);
+        }
+
+        unsigned int getMaxLength() const {
+            return header->maxLength;
+        }
+
+        /**
+         * @brief The number of algorithm numbers covered.
+         */
+        unsigned long long int getNumAlgorithms() const {
+            return header->numAlgorithms;
+        }
+
+        /**
+         * @brief The number of non-redundant algorithms, which have orders.
+         */
+        unsigned long long int getNumEntries() const {
+            return header->numEntries;
+        }
+
+        /**
+         * @brief Look up an order by algorithm number.
+         *
+         * @return unsigned int The order, or 0 if the algorithm is redundant or
+         * longer than the table covers.
+         */
+        unsigned int lookup(unsigned long long int algNum) const {
+            if (algNum >= header->numAlgorithms || !isSet(bitmap, algNum))
+                return 0;
+            return getPacked(orders, getRank(bitmap, directory, algNum));
+        }
+
+        unsigned int lookup(const Algorithm& algorithm) const {
+            if (algorithm.getLayerDepth() != 1)
+                return 0;
+            return lookup(algorithm.getAlgorithmNumber());
+        }
+
+        /**
+         * @brief The number of entries with algorithm numbers below algNum.
+         */
+        unsigned long long int rank(unsigned long long int algNum) const {
+            if (algNum >= header->numAlgorithms)
+                return header->numEntries;
+            return getRank(bitmap, directory, algNum);
+        }
+
+        /**
+         * @brief The number of algorithms with up to maxLength turns.
+         */
+        static unsigned long long int getNumAlgorithms(unsigned int maxLength) {
+            unsigned long long int total = 0;
+            unsigned long long int count = 1;
+            for (unsigned int length = 1; length <= maxLength; length++) {
+                count *= Algorithm::getAlgorithmBase(1);
+                total += count;
+            }
+            return total;
+        }
+
+        /**
+         * @brief Compute the order of every non-redundant algorithm with up to
+         * maxLength turns and write the table to path. The table is written
+         * to a temporary file that replaces path once it is complete.
+         *
+         * @throws std::runtime_error If the table cannot be written.
+         */
+        static void build(const std::string& path, unsigned int maxLength, unsigned int numThreads) {
+            if (numThreads < 1)
+                numThreads = 1;
+
+            Header h;
+            std::memset(&h, 0, sizeof(h));
+            std::memcpy(h.magic, getMagic(), sizeof(h.magic));
+            h.version = VERSION;
+            h.maxLength = maxLength;
+            h.numAlgorithms = getNumAlgorithms(maxLength);
+            h.bitmapWords = (h.numAlgorithms + 63) / 64;
+            h.directoryEntries = h.bitmapWords / SUPERBLOCK_WORDS + 1;
+
+            std::vector<uint64_t> bits(h.bitmapWords, 0);
+            {
+                StaticAlgorithms<&Algorithm::isRedundant> reduce(numThreads, h.numAlgorithms);
+                AlgorithmList* valid = reduce.getReduction();
+                for (unsigned long long int algNum : *valid)
+                    bits[algNum / 64] |= 1ULL << (algNum % 64);
+                h.numEntries = valid->size();
+            }
+
+            std::vector<uint64_t> ranks(h.directoryEntries, 0);
+            unsigned long long int rank = 0;
+            for (unsigned long long int w = 0; w < h.bitmapWords; w++) {
+                if (w % SUPERBLOCK_WORDS == 0)
+                    ranks[w / SUPERBLOCK_WORDS] = rank;
+                rank += (unsigned long long int)__builtin_popcountll(bits[w]);
+            }
+            if (h.bitmapWords % SUPERBLOCK_WORDS == 0)
+                ranks[h.bitmapWords / SUPERBLOCK_WORDS] = rank;
+
+            /* One spare word, so an entry can always be read as two words. */
+            h.orderWords = (h.numEntries*BITS_PER_ORDER + 63) / 64 + 1;
+            std::unique_ptr<std::atomic<uint64_t>[]> packed(new std::atomic<uint64_t>[h.orderWords]());
+
+            RangeScheduler scheduler(numThreads, 0, h.numAlgorithms, 4096);
+            std::vector<std::thread> threads;
+            for (unsigned int i = 0; i < numThreads; i++)
+                threads.emplace_back([&, i] {
+                    Algorithm algorithm;
+                    Cube c(CubieColor::RED, 3);
+                    RangeScheduler::Range range;
+                    while (scheduler.next(i, range)) {
+                        if (range.start < algorithm.getAlgorithmNumber())
+                            algorithm.reset();
+                        algorithm += range.start - algorithm.getAlgorithmNumber();
+                        unsigned long long int r = getRank(bits.data(), ranks.data(), range.start);
+                        for (unsigned long long int algNum = range.start; algNum < range.end; ++algNum, ++algorithm) {
+                            if (!isSet(bits.data(), algNum))
+                                continue;
+                            std::vector<Turn> turns = algorithm.getAlgorithm();
+                            unsigned int order = 0;
+                            do {
+                                ++order;
+                                c.performAlgorithm(turns);
+                            } while (!c.isSolved());
+                            setPacked(packed.get(), r++, order);
+                        }
+                    }
+                });
+            for (std::thread& t : threads)
+                t.join();
+
+            std::string tmpPath = path + ".tmp";
+            std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+            out.write((const char*)&h, sizeof(h));
+            out.write((const char*)bits.data(), (std::streamsize)(bits.size()*sizeof(uint64_t)));
+            out.write((const char*)ranks.data(), (std::streamsize)(ranks.size()*sizeof(uint64_t)));
+            for (unsigned long long int w = 0; w < h.orderWords; w++) {
+                uint64_t word = packed[w].load(std::memory_order_relaxed);
+                out.write((const char*)&word, sizeof(word));
+            }
+            out.close();
+            if (!out || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+                std::remove(tmpPath.c_str());
+                throw std::runtime_error("Cannot write " + path + ".");
+            }
+        }
+
+    private:
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t maxLength;
+            uint64_t numAlgorithms;
+            uint64_t numEntries;
+            uint64_t bitmapWords;
+            uint64_t directoryEntries;
+            uint64_t orderWords;
+            uint64_t reserved;
+        };
+
+        void* map;
+        size_t length;
+        const Header* header;
+        const uint64_t* bitmap;
+        const uint64_t* directory;
+        const uint64_t* orders;
+
+        static const char* getMagic() {
+            return "CUBEODB";
+        }
+
+        static size_t getFileSize(const Header& h) {
+            return sizeof(Header) + (size_t)(h.bitmapWords + h.directoryEntries + h.orderWords)*sizeof(uint64_t);
+        }
+
+        static bool isSet(const uint64_t* bits, unsigned long long int algNum) {
+            return (bits[algNum / 64] >> (algNum % 64)) & 1;
+        }
+
+        /* The number of set bits before algNum. */
+        static unsigned long long int getRank(const uint64_t* bits, const uint64_t* ranks,
+                                              unsigned long long int algNum) {
+            unsigned long long int word = algNum / 64;
+            unsigned long long int rank = ranks[word / SUPERBLOCK_WORDS];
+            for (unsigned long long int w = word - word % SUPERBLOCK_WORDS; w < word; w++)
+                rank += (unsigned long long int)__builtin_popcountll(bits[w]);
+            uint64_t below = (1ULL << (algNum % 64)) - 1;
+            return rank + (unsigned long long int)__builtin_popcountll(bits[word] & below);
+        }
+
+        static unsigned int getPacked(const uint64_t* words, unsigned long long int index) {
+            unsigned long long int bit = index*BITS_PER_ORDER;
+            unsigned int shift = (unsigned int)(bit % 64);
+            uint64_t value = words[bit / 64] >> shift;
+            if (shift + BITS_PER_ORDER > 64)
+                value |= words[bit / 64 + 1] << (64 - shift);
+            return (unsigned int)(value & ((1U << BITS_PER_ORDER) - 1));
+        }
+
+        static void setPacked(std::atomic<uint64_t>* words, unsigned long long int index, unsigned int order) {
+            unsigned long long int bit = index*BITS_PER_ORDER;
+            unsigned int shift = (unsigned int)(bit % 64);
+            uint64_t value = order & ((1U << BITS_PER_ORDER) - 1);
+            words[bit / 64].fetch_or(value << shift, std::memory_order_relaxed);
+            if (shift + BITS_PER_ORDER > 64)
+                words[bit / 64 + 1].fetch_or(value >> (64 - shift), std::memory_order_relaxed);
+        }
+};
+
+#endif // ORDERDATABASE_H
@@ -0,0 +1,188 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Counts of algorithms by order and by algorithm length. Each worker fills
+ *    its own OrderHistogram without any locking, and the per-worker
+ *    histograms are merged into one once the workers are done.
+ */
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef ORDERHISTOGRAM_H
+#define ORDERHISTOGRAM_H
+
+class OrderHistogram {
+    public:
+        OrderHistogram(size_t numOrders) : numOrders(numOrders) {}
+
+        /**
+         * @brief Count algorithms of one order and length. Orders past
+         * numOrders are ignored.
+         */
+        void add(size_t order, size_t length, unsigned long long int n = 1) {
+            if (order >= numOrders)
+                return;
+            if (length >= counts.size())
+                counts.resize(length + 1, std::vector<unsigned long long int>(numOrders, 0));
+            counts[length][order] += n;
+        }
+
+        void clear() {
+            for (std::vector<unsigned long long int>& c : counts)
+                std::fill(c.begin(), c.end(), 0);
+        }
+
+        void merge(const OrderHistogram& other) {
+            if (other.counts.size() > counts.size())
+                counts.resize(other.counts.size(), std::vector<unsigned long long int>(numOrders, 0));
+            for (size_t length = 0; length < other.counts.size(); length++)
+                for (size_t order = 0; order < numOrders && order < other.numOrders; order++)
+                    counts[length][order] += other.counts[length][order];
+        }
+
+        unsigned long long int get(size_t order, size_t length) const {
+            if (order >= numOrders || length >= counts.size())
+                return 0;
+            return counts[length][order];
+        }
+
+        /**
+         * @brief Count for an order over every length.
+         */
+        unsigned long long int get(size_t order) const {
+            unsigned long long int total = 0;
+            for (size_t length = 0; length < counts.size(); length++)
+                total += get(order, length);
+            return total;
+        }
+
+        unsigned long long int getTotal() const {
+            unsigned long long int total = 0;
+            for (size_t order = 0; order < numOrders; order++)
+                total += get(order);
+            return total;
+        }
+
+        size_t getNumOrders() const {
+            return numOrders;
+        }
+
+        /**
+         * @brief One past the longest algorithm counted.
+         */
+        size_t getLengths() const {
+            return counts.size();
+        }
+
+        /**
+         * @brief Print a table with a row per order that has any algorithms.
+         *
+         * @param byLength Add a column per algorithm length.
+         */
+        void print(std::ostream& out, bool byLength) const {
+            const int width = 12;
+            size_t minLength = getLengths();
+            for (size_t length = 0; length < getLengths() && minLength == getLengths(); length++)
+                for (size_t order = 0; order < numOrders; order++)
+                    if (get(order, length) > 0) {
+                        minLength = length;
+                        break;
+                    }
+
+            out << std::setw(width) << std::left << "Order";
+            for (size_t length = minLength; byLength && length < getLengths(); length++)
+                out << std::setw(width) << std::left << ("Length " + std::to_string(length));
+            out << std::setw(width) << std::left << "Total" << std::endl;
+
+            for (size_t order = 0; order < numOrders; order++) {
+                if (get(order) == 0)
+                    continue;
+                out << std::setw(width) << std::left << order;
+                for (size_t length = minLength; byLength && length < getLengths(); length++)
+                    out << std::setw(width) << std::left << get(order, length);
+                out << std::setw(width) << std::left << get(order) << std::endl;
+            }
+
+            out << std::setw(width) << std::left << "Total";
+            for (size_t length = minLength; byLength && length < getLengths(); length++) {
+                unsigned long long int total = 0;
+                for (size_t order = 0; order < numOrders; order++)
+                    total += get(order, length);
+                out << std::setw(width) << std::left << total;
+            }
+            out << std::setw(width) << std::left << getTotal() << std::endl;
+        }
+
+        /**
+         * @brief Add the counts of a table written by print. Without length
+         * columns, the counts are added at length 0.
+         *
+         * @param byLength Set to whether the table had length columns.
+         * @return false If in does not hold a table.
+         */
+        bool read(std::istream& in, bool& byLength) {
+            std::string line, word;
+            if (!std::getline(in, line))
+                return false;
+            std::istringstream header(line);
+            if (!(header >> word) || word != "Order")
+                return false;
+
+            std::vector<size_t> lengths;
+            while (header >> word && word == "Length") {
+                size_t length;
+                if (!(header >> length))
+                    return false;
+                lengths.push_back(length);
+            }
+            byLength = !lengths.empty();
+
+            while (std::getline(in, line)) {
+                std::istringstream row(line);
+                size_t order;
+                if (!(row >> order))
+                    break; // The Total row.
+                unsigned long long int n;
+                for (size_t length : lengths)
+                    if (row >> n)
+                        add(order, length, n);
+                if (lengths.empty() && row >> n)
+                    add(order, 0, n);
+            }
+            return true;
+        }
+
+    private:
+        size_t numOrders;
+        std::vector<std::vector<unsigned long long int>> counts;
+};
+
+#endif // ORDERHISTOGRAM_H
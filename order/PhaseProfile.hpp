@@ -0,0 +1,199 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Where the time of a search goes, for builds with -DCUBE_PROFILE (make
+ *    profile). Every SAMPLE_EVERY-th algorithm a thread walks is sampled: the
+ *    increment to the next algorithm, the redundancy check, the turns and the
+ *    solved checks are timed with the time stamp counter and added to the
+ *    thread's PhaseTimes. At exit the totals are scaled to ns per algorithm
+ *    walked, calibrated against the steady clock over the whole run.
+ *
+ *    SAMPLE_EVERY is prime so that it does not line up with --skip-nth or the
+ *    turn digits of the algorithm number. Timing a phase costs two reads of
+ *    the counter, which shows up in the shortest phases, mostly the solved
+ *    check.
+ *
+ *    Without CUBE_PROFILE the PROFILE_ macros expand to nothing, or to the
+ *    expression they wrap, and this file declares nothing else.
+ */
+
+#ifdef CUBE_PROFILE
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#endif // CUBE_PROFILE
+
+#ifndef PHASEPROFILE_H
+#define PHASEPROFILE_H
+
+#ifdef CUBE_PROFILE
+
+struct alignas(64) PhaseTimes {
+    enum Phase {ENUMERATE, FILTER, SIMULATE, SOLVED_CHECK, NUM_PHASES};
+
+    uint64_t ticks[NUM_PHASES] = {};
+    uint64_t sampled = 0;
+    uint64_t walked = 0;
+};
+
+class PhaseProfile {
+    public:
+        static const uint64_t SAMPLE_EVERY = 61;
+
+        PhaseProfile(size_t numThreads) : times(numThreads),
+            startTicks(now()), startTime(std::chrono::steady_clock::now()) {
+            active = this;
+        }
+
+        PhaseProfile(const PhaseProfile&) = delete;
+        PhaseProfile& operator=(const PhaseProfile&) = delete;
+
+        ~PhaseProfile() {
+            active = nullptr;
+        }
+
+        /**
+         * @brief Send the phase times of the calling thread to a thread slot.
+         * Threads that never bind are not timed.
+         */
+        static void bind(size_t threadNum) {
+            current = active != nullptr && threadNum < active->times.size() ?
+                      &active->times[threadNum] : nullptr;
+            sampling = false;
+        }
+
+        /**
+         * @brief Count an algorithm walked and decide whether it is timed.
+         */
+        static void walk(unsigned long long int algorithmCount) {
+            if (current == nullptr)
+                return;
+            ++current->walked;
+            sampling = algorithmCount % SAMPLE_EVERY == 0;
+            current->sampled += sampling;
+        }
+
+        static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+        }
+
+        /**
+         * @brief Print ns per algorithm walked for each phase and thread.
+         */
+        void print(std::ostream& out) const {
+            double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - startTime).count();
+            uint64_t ticks = now() - startTicks;
+            double nsPerTick = ticks > 0 ? ns / (double)ticks : 0.0;
+
+            out << "Phase profile, ns per algorithm, 1 in " << SAMPLE_EVERY << " sampled" << std::endl;
+            out << "Thread    Enumerate    Filter  Simulate    Solved     Total     Walked" << std::endl;
+            PhaseTimes all;
+            for (size_t i = 0; i < times.size(); i++) {
+                printRow(out, std::to_string(i), times[i], nsPerTick);
+                for (int phase = 0; phase < PhaseTimes::NUM_PHASES; phase++)
+                    all.ticks[phase] += times[i].ticks[phase];
+                all.sampled += times[i].sampled;
+                all.walked += times[i].walked;
+            }
+            printRow(out, "All", all, nsPerTick);
+        }
+
+        class Scope {
+            public:
+                Scope(PhaseTimes::Phase phase) : phase(phase),
+                    start(sampling ? now() : 0) {}
+
+                ~Scope() {
+                    if (sampling)
+                        current->ticks[phase] += now() - start;
+                }
+
+            private:
+                PhaseTimes::Phase phase;
+                uint64_t start;
+        };
+
+    private:
+        static inline PhaseProfile* active = nullptr;
+        static inline thread_local PhaseTimes* current = nullptr;
+        static inline thread_local bool sampling = false;
+
+        std::vector<PhaseTimes> times;
+        uint64_t startTicks;
+        std::chrono::steady_clock::time_point startTime;
+
+        static void printRow(std::ostream& out, const std::string& name, const PhaseTimes& row, double nsPerTick) {
+            char line[128];
+            double perAlgorithm[PhaseTimes::NUM_PHASES];
+            double total = 0.0;
+            for (int phase = 0; phase < PhaseTimes::NUM_PHASES; phase++) {
+                /* Each sample stands for the SAMPLE_EVERY algorithms around it. */
+                perAlgorithm[phase] = row.sampled > 0 ?
+                    (double)row.ticks[phase] * nsPerTick / (double)row.sampled : 0.0;
+                total += perAlgorithm[phase];
+            }
+            std::snprintf(line, sizeof(line), "%-6s %12.2f %9.2f %9.2f %9.2f %9.2f %10llu",
+                          name.c_str(), perAlgorithm[PhaseTimes::ENUMERATE],
+                          perAlgorithm[PhaseTimes::FILTER], perAlgorithm[PhaseTimes::SIMULATE],
+                          perAlgorithm[PhaseTimes::SOLVED_CHECK], total,
+                          (unsigned long long int)row.walked);
+            out << line << std::endl;
+        }
+};
+
+#define PROFILE_START(numThreads) PhaseProfile phaseProfile(numThreads)
+#define PROFILE_PRINT(out) phaseProfile.print(out)
+#define PROFILE_BIND(threadNum) PhaseProfile::bind(threadNum)
+#define PROFILE_WALK(algorithmCount) PhaseProfile::walk(algorithmCount)
+#define PROFILE_SCOPE(phase) PhaseProfile::Scope phaseScope(PhaseTimes::phase)
+#define PROFILE_TIMED(phase, expr) [&]() -> decltype(auto) { PROFILE_SCOPE(phase); return (expr); }()
+
+#else
+
+#define PROFILE_START(numThreads)
+#define PROFILE_PRINT(out)
+#define PROFILE_BIND(threadNum)
+#define PROFILE_WALK(algorithmCount)
+#define PROFILE_SCOPE(phase)
+#define PROFILE_TIMED(phase, expr) (expr)
+
+#endif // CUBE_PROFILE
+
+#endif // PHASEPROFILE_H
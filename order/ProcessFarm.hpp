@@ -0,0 +1,200 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    A fixed number of forked worker processes, each connected to the parent
+ *    by its own socketpair. The parent talks to a worker through getFd, and
+ *    restarts a worker that has died with restart.
+ *
+ *    Workers run body(fd, index) and exit with its return value. They are
+ *    forked from the calling thread, so the parent should not have started
+ *    any other threads when it creates or restarts workers.
+ *
+ *    With pin set, worker i is bound to the i-th of numWorkers contiguous
+ *    slices of the CPUs the parent may run on. Neighbouring CPU numbers
+ *    usually share a NUMA node, so this keeps each worker, its threads and
+ *    its memory on one node without needing libnuma.
+ */
+
+#include <csignal>
+#include <cerrno>
+#include <functional>
+#include <sched.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef PROCESSFARM_H
+#define PROCESSFARM_H
+
+class ProcessFarm {
+    public:
+        typedef std::function<int(int fd, size_t index)> Body;
+
+        ProcessFarm(size_t numWorkers, Body body, bool pin) :
+                    body(body), pin(pin), workers(numWorkers < 1 ? 1 : numWorkers) {
+            /* A dead worker must show up as a failed write, not kill the parent. */
+            std::signal(SIGPIPE, SIG_IGN);
+
+            cpu_set_t allowed;
+            CPU_ZERO(&allowed);
+            if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+                for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+                    if (CPU_ISSET(cpu, &allowed))
+                        cpus.push_back(cpu);
+
+            for (size_t i = 0; i < workers.size(); i++)
+                start(i);
+        }
+
+        ProcessFarm(const ProcessFarm&) = delete;
+        ProcessFarm& operator=(const ProcessFarm&) = delete;
+
+        /**
+         * @brief Close every connection and wait for the workers to exit.
+         */
+        ~ProcessFarm() {
+            for (size_t i = 0; i < workers.size(); i++)
+                reap(i);
+        }
+
+        size_t size() const {
+            return workers.size();
+        }
+
+        int getFd(size_t worker) const {
+            return workers.at(worker).fd;
+        }
+
+        /**
+         * @brief Replace a worker that has died or stopped responding.
+         */
+        void restart(size_t worker) {
+            stop(worker);
+            start(worker);
+        }
+
+        /**
+         * @brief Kill a worker without replacing it.
+         */
+        void stop(size_t worker) {
+            if (workers.at(worker).pid > 0)
+                ::kill(workers[worker].pid, SIGKILL);
+            reap(worker);
+        }
+
+        static bool readAll(int fd, void* data, size_t size) {
+            char* p = (char*)data;
+            while (size > 0) {
+                ssize_t n = ::read(fd, p, size);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                p += n;
+                size -= (size_t)n;
+            }
+            return true;
+        }
+
+        static bool writeAll(int fd, const void* data, size_t size) {
+            const char* p = (const char*)data;
+            while (size > 0) {
+                ssize_t n = ::write(fd, p, size);
+                if (n < 0 && errno == EINTR)
+                    continue;
+                if (n <= 0)
+                    return false;
+                p += n;
+                size -= (size_t)n;
+            }
+            return true;
+        }
+
+    private:
+        struct Worker {
+            pid_t pid = -1;
+            int fd = -1;
+        };
+
+        Body body;
+        bool pin;
+        std::vector<int> cpus;
+        std::vector<Worker> workers;
+
+        void start(size_t worker) {
+            int fds[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+                throw std::runtime_error("Unable to create a worker socket.");
+
+            pid_t pid = fork();
+            if (pid < 0)
+                throw std::runtime_error("Unable to fork a worker.");
+            if (pid == 0) {
+                ::close(fds[0]);
+                for (const Worker& w : workers)
+                    if (w.fd >= 0)
+                        ::close(w.fd);
+                if (pin)
+                    bind(worker);
+                ::_exit(body(fds[1], worker));
+            }
+
+            ::close(fds[1]);
+            workers[worker].pid = pid;
+            workers[worker].fd = fds[0];
+        }
+
+        void reap(size_t worker) {
+            Worker& w = workers[worker];
+            if (w.fd >= 0)
+                ::close(w.fd);
+            if (w.pid > 0)
+                while (waitpid(w.pid, nullptr, 0) < 0 && errno == EINTR);
+            w.fd = -1;
+            w.pid = -1;
+        }
+
+        void bind(size_t worker) {
+            if (cpus.empty())
+                return;
+            size_t n = workers.size();
+            size_t first = worker*cpus.size()/n;
+            size_t last = (worker + 1)*cpus.size()/n;
+            if (last <= first)
+                last = first + 1;
+
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (size_t i = first; i < last; i++)
+                CPU_SET(cpus[i % cpus.size()], &set);
+            sched_setaffinity(0, sizeof(set), &set);
+        }
+};
+
+#endif // PROCESSFARM_H
@@ -0,0 +1,167 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Splits the index range [start, end) into fixed size chunks and hands them
+ *    out to a fixed number of workers. Each worker owns a deque of chunks. A
+ *    worker takes chunks from the front of its own deque and, once that is
+ *    empty, steals the back half of another worker's deque.
+ *
+ *    Chunks are dealt round robin (chunk c goes to worker c % numWorkers), so
+ *    every worker starts near the low end of the range and the range is
+ *    covered roughly in order. That keeps --find-orders style searches
+ *    looking at short algorithms first, while each worker still walks a whole
+ *    chunk of neighbouring indices on its own.
+ *
+ *    Since the chunks of a deque are evenly spaced, a deque is stored as the
+ *    index of its front chunk, a chunk count, and the spacing between chunks.
+ *    Stealing half a deque yields another evenly spaced deque.
+ */
+
+#include <mutex>
+#include <vector>
+
+#ifndef RANGESCHEDULER_H
+#define RANGESCHEDULER_H
+
+class RangeScheduler {
+    public:
+        struct Range {
+            unsigned long long int start;
+            unsigned long long int end;
+            unsigned long long int chunk; // Index of the chunk in the whole range.
+        };
+
+        RangeScheduler(size_t numWorkers, unsigned long long int start,
+                       unsigned long long int end, unsigned long long int chunkSize) :
+                       start(start), end(end), chunkSize(chunkSize),
+                       deques(numWorkers < 1 ? 1 : numWorkers) {
+            if (this->chunkSize < 1)
+                this->chunkSize = 1;
+
+            if (end > start)
+                numChunks = (end - start + this->chunkSize - 1) / this->chunkSize;
+
+            unsigned long long int n = deques.size();
+            for (unsigned long long int w = 0; w < n; w++) {
+                deques[w].front = w;
+                deques[w].count = numChunks > w ? (numChunks - w + n - 1) / n : 0;
+                deques[w].stride = n;
+            }
+        }
+
+        /**
+         * @brief Get the next chunk for a worker.
+         *
+         * @param worker The worker asking for work, zero indexed.
+         * @param range Set to the chunk's index range.
+         * @return true If range holds a chunk.
+         * @return false If every chunk has been handed out.
+         */
+        bool next(size_t worker, Range& range) {
+            Deque& own = deques.at(worker);
+            {
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (own.count > 0) {
+                    range = getRange(own.front);
+                    own.front += own.stride;
+                    --own.count;
+                    return true;
+                }
+            }
+            return steal(worker, range);
+        }
+
+        unsigned long long int getChunkSize() const {
+            return chunkSize;
+        }
+
+        unsigned long long int getNumChunks() const {
+            return numChunks;
+        }
+
+        /**
+         * @brief The first index of a chunk, or the end of the range for the
+         * chunk after the last one.
+         */
+        unsigned long long int getStart(unsigned long long int chunk) const {
+            return chunk < numChunks ? start + chunk*chunkSize : end;
+        }
+
+    private:
+        struct alignas(64) Deque {
+            std::mutex mutex;
+            unsigned long long int front = 0;
+            unsigned long long int count = 0;
+            unsigned long long int stride = 1;
+        };
+
+        unsigned long long int start;
+        unsigned long long int end;
+        unsigned long long int chunkSize;
+        unsigned long long int numChunks = 0;
+        std::vector<Deque> deques;
+
+        Range getRange(unsigned long long int chunk) const {
+            Range range;
+            range.chunk = chunk;
+            range.start = start + chunk*chunkSize;
+            range.end = (end - range.start) > chunkSize ? range.start + chunkSize : end;
+            return range;
+        }
+
+        /**
+         * Take the back half of the next non-empty deque, starting with the
+         * worker after this one. The first stolen chunk is returned to the
+         * caller and the rest becomes its deque.
+         */
+        bool steal(size_t worker, Range& range) {
+            size_t n = deques.size();
+            for (size_t i = 1; i < n; i++) {
+                Deque& victim = deques[(worker + i) % n];
+                unsigned long long int front, count, stride;
+                {
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if (victim.count == 0)
+                        continue;
+                    count = (victim.count + 1) / 2;
+                    victim.count -= count;
+                    stride = victim.stride;
+                    front = victim.front + victim.count*stride;
+                }
+
+                range = getRange(front);
+                Deque& own = deques[worker];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                own.front = front + stride;
+                own.count = count - 1;
+                own.stride = stride;
+                return true;
+            }
+            return false;
+        }
+};
+
+#endif // RANGESCHEDULER_H
@@ -0,0 +1,100 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Puts items that finish out of order back into sequence order. Any thread
+ *    may put an item with its sequence number, and one consumer takes them
+ *    out in order, waiting for gaps to fill.
+ *
+ *    The buffer does not bound itself. Producers keep it small by having no
+ *    more than a fixed number of items in flight, e.g. by recycling a fixed
+ *    pool of batches that the consumer hands back.
+ */
+
+#include <condition_variable>
+#include <limits>
+#include <map>
+#include <mutex>
+
+#ifndef REORDERBUFFER_H
+#define REORDERBUFFER_H
+
+template<typename T>
+class ReorderBuffer {
+    public:
+        void put(unsigned long long int sequence, T item) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.emplace(sequence, std::move(item));
+            }
+            ready.notify_one();
+        }
+
+        /**
+         * @brief Wait for the next item in sequence.
+         *
+         * @return false Once every item up to finish's total has been taken.
+         */
+        bool next(T& item) {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [this] {
+                return expected == total || (!pending.empty() && pending.begin()->first == expected);
+            });
+            if (expected == total)
+                return false;
+            item = std::move(pending.begin()->second);
+            pending.erase(pending.begin());
+            ++expected;
+            return true;
+        }
+
+        /**
+         * @brief Declare the number of items that will be put in total.
+         */
+        void finish(unsigned long long int total) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                this->total = total;
+            }
+            ready.notify_all();
+        }
+
+        /**
+         * @brief The sequence number next will return.
+         */
+        unsigned long long int getExpected() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return expected;
+        }
+
+    private:
+        std::map<unsigned long long int, T> pending;
+        std::mutex mutex;
+        std::condition_variable ready;
+        unsigned long long int expected = 0;
+        unsigned long long int total = std::numeric_limits<unsigned long long int>::max();
+};
+
+#endif // REORDERBUFFER_H
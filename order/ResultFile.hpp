@@ -0,0 +1,320 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    A compact binary alternative to the TN:/AN:/OR:/AG: text output. A file
+ *    is a header followed by blocks of up to BLOCK_RECORDS results. Within a
+ *    block each field is stored as its own column:
+ *
+ *       header: "CUBERES\0" <u32 version> <u32 layer depth>
+ *               <u32 start length> <start algorithm>
+ *       block:  <u32 records> <u32 payload bytes>
+ *               <u32 bytes> algorithm numbers, zigzag varint deltas
+ *               <u32 bytes> orders, varints
+ *               <u32 bytes> algorithm lengths, varints
+ *
+ *    Algorithm numbers are counted from the start algorithm, like AN: in the
+ *    text output, in the alphabet of the recorded layer depth. The start
+ *    algorithm alone does not fix that depth: "R U" is numbered differently
+ *    in a search that also turns inner slices. Each number is stored as the
+ *    difference from the previous number in the block, so runs from one
+ *    worker usually take one or two bytes. The turns are not stored, since
+ *    they follow from the start algorithm, the layer depth and the algorithm
+ *    number. Integers are in host byte order.
+ *
+ *    ResultFileReader maps the file and decodes one block at a time. The
+ *    varints are read from the mapping and expanded into the Block's column
+ *    vectors, which keep their capacity from one block to the next.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#ifndef RESULTFILE_H
+#define RESULTFILE_H
+
+struct ResultFileFormat {
+    static const uint32_t VERSION = 2;
+    static const size_t BLOCK_RECORDS = 65536;
+    static const size_t MAGIC_SIZE = 8;
+
+    static const char* getMagic() {
+        return "CUBERES";
+    }
+
+    static void putVarint(std::string& out, unsigned long long int value) {
+        while (value >= 0x80) {
+            out += (char)((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out += (char)value;
+    }
+
+    /**
+     * @throws std::runtime_error If the varint runs past end.
+     */
+    static unsigned long long int getVarint(const unsigned char*& in, const unsigned char* end) {
+        unsigned long long int value = 0;
+        for (unsigned int shift = 0; in < end && shift < 64; shift += 7) {
+            unsigned char byte = *in++;
+            value |= (unsigned long long int)(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        throw std::runtime_error("Corrupt varint in result file.");
+    }
+
+    static unsigned long long int zigzag(long long int value) {
+        return ((unsigned long long int)value << 1) ^ (unsigned long long int)(value >> 63);
+    }
+
+    static long long int unzigzag(unsigned long long int value) {
+        return (long long int)(value >> 1) ^ -(long long int)(value & 1);
+    }
+
+    static void putU32(std::string& out, uint32_t value) {
+        out.append((const char*)&value, sizeof(value));
+    }
+
+    static uint32_t getU32(const unsigned char*& in, const unsigned char* end) {
+        uint32_t value;
+        if ((size_t)(end - in) < sizeof(value))
+            throw std::runtime_error("Truncated result file.");
+        std::memcpy(&value, in, sizeof(value));
+        in += sizeof(value);
+        return value;
+    }
+};
+
+/**
+ * Encodes results into an output string. The caller decides when and where
+ * the string is written; whole blocks are appended to it.
+ */
+class ResultFileWriter {
+    public:
+        /**
+         * @param layerDepth The layer depth of the alphabet the algorithm
+         * numbers are counted in.
+         */
+        ResultFileWriter(std::string& out, const std::string& startAlgorithm, unsigned int layerDepth) : out(out) {
+            out.append(ResultFileFormat::getMagic(), ResultFileFormat::MAGIC_SIZE);
+            ResultFileFormat::putU32(out, ResultFileFormat::VERSION);
+            ResultFileFormat::putU32(out, layerDepth);
+            ResultFileFormat::putU32(out, (uint32_t)startAlgorithm.size());
+            out += startAlgorithm;
+        }
+
+        void add(unsigned long long int algNum, unsigned int order, unsigned int length) {
+            ResultFileFormat::putVarint(algNums, ResultFileFormat::zigzag((long long int)(algNum - previous)));
+            ResultFileFormat::putVarint(orders, order);
+            ResultFileFormat::putVarint(lengths, length);
+            previous = algNum;
+            if (++count == ResultFileFormat::BLOCK_RECORDS)
+                flushBlock();
+        }
+
+        /**
+         * @brief Append the partly filled block, if any.
+         */
+        void flushBlock() {
+            if (count == 0)
+                return;
+            ResultFileFormat::putU32(out, (uint32_t)count);
+            ResultFileFormat::putU32(out, (uint32_t)(3*sizeof(uint32_t) + algNums.size() + orders.size() + lengths.size()));
+            for (std::string* column : {&algNums, &orders, &lengths}) {
+                ResultFileFormat::putU32(out, (uint32_t)column->size());
+                out += *column;
+                column->clear();
+            }
+            count = 0;
+            previous = 0;
+        }
+
+    private:
+        std::string& out;
+        std::string algNums;
+        std::string orders;
+        std::string lengths;
+        size_t count = 0;
+        unsigned long long int previous = 0;
+};
+
+/**
+ * Reads a result file through a read only memory mapping.
+ */
+class ResultFileReader {
+    public:
+        struct Block {
+            std::vector<unsigned long long int> algNums;
+            std::vector<uint16_t> orders;
+            std::vector<unsigned int> lengths;
+
+            size_t size() const {
+                return algNums.size();
+            }
+        };
+
+        /**
+         * @throws std::runtime_error If the file cannot be mapped or is not a
+         * result file.
+         */
+        ResultFileReader(const std::string& path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw std::runtime_error("Cannot open " + path + ".");
+            struct stat st;
+            if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+                ::close(fd);
+                throw std::runtime_error("Cannot read " + path + ".");
+            }
+            length = (size_t)st.st_size;
+            void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd);
+            if (map == MAP_FAILED)
+                throw std::runtime_error("Cannot map " + path + ".");
+            madvise(map, length, MADV_SEQUENTIAL);
+            data = (const unsigned char*)map;
+            end = data + length;
+
+            cursor = data;
+            if (length < ResultFileFormat::MAGIC_SIZE ||
+                std::memcmp(cursor, ResultFileFormat::getMagic(), ResultFileFormat::MAGIC_SIZE) != 0) {
+                munmap((void*)data, length);
+                throw std::runtime_error(path + " is not a result file.");
+            }
+            cursor += ResultFileFormat::MAGIC_SIZE;
+            try {
+                if (ResultFileFormat::getU32(cursor, end) != ResultFileFormat::VERSION)
+                    throw std::runtime_error(path + " has an unsupported version.");
+                layerDepth = ResultFileFormat::getU32(cursor, end);
+                if (layerDepth < 1)
+                    throw std::runtime_error(path + " is not a result file.");
+                uint32_t startLength = ResultFileFormat::getU32(cursor, end);
+                if ((size_t)(end - cursor) < startLength)
+                    throw std::runtime_error("Truncated result file.");
+                startAlgorithm.assign((const char*)cursor, startLength);
+                cursor += startLength;
+            } catch (...) {
+                munmap((void*)data, length);
+                throw;
+            }
+        }
+
+        ResultFileReader(const ResultFileReader&) = delete;
+        ResultFileReader& operator=(const ResultFileReader&) = delete;
+
+        ~ResultFileReader() {
+            munmap((void*)data, length);
+        }
+
+        /**
+         * @brief The algorithm that algorithm number 0 refers to.
+         */
+        const std::string& getStartAlgorithm() const {
+            return startAlgorithm;
+        }
+
+        /**
+         * @brief The layer depth the algorithm numbers are counted in.
+         */
+        unsigned int getLayerDepth() const {
+            return layerDepth;
+        }
+
+        /**
+         * @brief Decode the next block.
+         *
+         * @return false At the end of the file.
+         * @throws std::runtime_error If the block is truncated or corrupt.
+         */
+        bool next(Block& block) {
+            if (cursor == end)
+                return false;
+            uint32_t count = ResultFileFormat::getU32(cursor, end);
+            uint32_t bytes = ResultFileFormat::getU32(cursor, end);
+            if ((size_t)(end - cursor) < bytes)
+                throw std::runtime_error("Truncated result file.");
+            const unsigned char* blockEnd = cursor + bytes;
+
+            block.algNums.resize(count);
+            block.orders.resize(count);
+            block.lengths.resize(count);
+
+            const unsigned char* column = getColumn(blockEnd);
+            unsigned long long int algNum = 0;
+            for (uint32_t i = 0; i < count; i++) {
+                algNum += (unsigned long long int)ResultFileFormat::unzigzag(ResultFileFormat::getVarint(column, cursor));
+                block.algNums[i] = algNum;
+            }
+            column = getColumn(blockEnd);
+            for (uint32_t i = 0; i < count; i++)
+                block.orders[i] = (uint16_t)ResultFileFormat::getVarint(column, cursor);
+            column = getColumn(blockEnd);
+            for (uint32_t i = 0; i < count; i++)
+                block.lengths[i] = (unsigned int)ResultFileFormat::getVarint(column, cursor);
+
+            if (cursor != blockEnd)
+                throw std::runtime_error("Corrupt block in result file.");
+            return true;
+        }
+
+        /**
+         * @brief Call f(algNum, order, length) for every remaining result.
+         */
+        template<typename F>
+        void forEach(F f) {
+            Block block;
+            while (next(block))
+                for (size_t i = 0; i < block.size(); i++)
+                    f(block.algNums[i], block.orders[i], block.lengths[i]);
+        }
+
+    private:
+        const unsigned char* data;
+        const unsigned char* end;
+        const unsigned char* cursor;
+        size_t length;
+        uint32_t layerDepth;
+        std::string startAlgorithm;
+
+        /* Returns the start of the next column and moves cursor past it. */
+        const unsigned char* getColumn(const unsigned char* blockEnd) {
+            uint32_t bytes = ResultFileFormat::getU32(cursor, blockEnd);
+            if ((size_t)(blockEnd - cursor) < bytes)
+                throw std::runtime_error("Corrupt block in result file.");
+            const unsigned char* column = cursor;
+            cursor += bytes;
+            return column;
+        }
+};
+
+#endif // RESULTFILE_H
@@ -0,0 +1,445 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Moves result output off the worker threads. Each worker pushes fixed size
+ *    binary records into its own SpscRing, and a single writer thread drains
+ *    the rings, formats the records into one buffer and hands the buffer to
+ *    write(2) in large pieces. Workers never take a lock or wait on the
+ *    output device unless their ring is full.
+ *
+ *    Records from one worker are written in the order they were pushed.
+ *    Records from different workers are interleaved in drain order.
+ *
+ *    The buffer is written once it holds BUFFER_SIZE bytes, or once the
+ *    oldest formatted record has waited flushInterval. A flushInterval of
+ *    zero writes after every drain pass.
+ *
+ *    When every ring is empty the writer thread blocks on a condition
+ *    variable. With nothing waiting to be written, the next record wakes it.
+ *    Otherwise it sleeps until the flush is due, and only a ring filling
+ *    past half its capacity wakes it early. A producer checks whether the
+ *    writer is asleep after each push, which costs a fence but no lock.
+ *
+ *    In BINARY format the results are written as a ResultFile instead of
+ *    text, and heartbeats go to stderr so they do not corrupt the file.
+ *
+ *    A worker that finishes a chunk of work pushes a chunk record after its
+ *    results. Once a write has reached the output, the flush listener is told
+ *    which chunks and which result orders it covered, so a checkpoint never
+ *    counts a chunk whose results were still queued.
+ *
+ *    With orderChunks, the writer holds each ordered producer's records until
+ *    its chunk record arrives, and writes whole chunks in chunk index order.
+ *    The writer does not bound the chunks it holds. Producers keep it small by
+ *    not starting a chunk far past getNextChunk.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "../Algorithm.hpp"
+#include "ResultFile.hpp"
+#include "SpscRing.hpp"
+#include "TraceRecorder.hpp"
+
+#ifndef RESULTWRITER_H
+#define RESULTWRITER_H
+
+struct ResultRecord {
+    static const unsigned int MAX_TURNS = 16;
+
+    enum Kind : unsigned char {
+        RESULT,
+        CONTINUATION, // More turns of the preceding RESULT.
+        HEARTBEAT,
+        CHUNK // A chunk of work is complete. algNum holds the chunk index.
+    };
+
+    Kind kind = RESULT;
+    bool more = false; // A CONTINUATION record follows.
+    unsigned char numTurns = 0;
+    unsigned int threadNum = 0;
+    unsigned int order = 0;
+    unsigned int length = 0; // Turns in the whole algorithm.
+    unsigned long long int algNum = 0;
+    Turn turns[MAX_TURNS];
+};
+
+class ResultWriter {
+    public:
+        static const size_t DEFAULT_RING_SIZE = 1024;
+        static const size_t BUFFER_SIZE = 1 << 20;
+
+        enum Format {
+            TEXT,
+            BINARY
+        };
+
+        typedef std::function<void(const std::vector<unsigned long long int>& chunks,
+                                   const std::vector<unsigned int>& orders)> FlushListener;
+
+        /**
+         * @param start Recorded in BINARY output with its layer depth, since
+         * algorithm numbers are relative to it and counted in its alphabet.
+         */
+        ResultWriter(size_t numProducers, int fd, unsigned long long int flushMs,
+                     Format format = TEXT, const Algorithm& start = Algorithm(),
+                     size_t ringSize = DEFAULT_RING_SIZE) :
+                     fd(fd), flushInterval(flushMs), format(format), layerDepth(start.getLayerDepth()),
+                     stopping(false), numOrdered(0), nextChunk(0) {
+            for (size_t i = 0; i < (numProducers < 1 ? 1 : numProducers); i++)
+                rings.emplace_back(new SpscRing<ResultRecord>(ringSize));
+            buffer.reserve(BUFFER_SIZE + 4096);
+            if (format == BINARY)
+                file.reset(new ResultFileWriter(buffer, start.getAlgorithmStr(), start.getLayerDepth()));
+            thread = std::thread(&ResultWriter::run, this);
+        }
+
+        ResultWriter(const ResultWriter&) = delete;
+        ResultWriter& operator=(const ResultWriter&) = delete;
+
+        ~ResultWriter() {
+            stop();
+        }
+
+        /**
+         * @brief Whether alg can be written with its own algorithm number.
+         * BINARY output counts every number in the start algorithm's layer
+         * depth, and the same number reads back as other turns at another.
+         */
+        bool canNumber(const Algorithm& alg) const {
+            return format == TEXT || alg.getLayerDepth() == layerDepth;
+        }
+
+        /**
+         * @brief Queue a result. Only the thread that owns producer may call
+         * this for that producer.
+         *
+         * @param threadNum The thread reported in the TN: field.
+         */
+        void pushResult(size_t producer, unsigned int threadNum, unsigned long long int algNum,
+                        const std::vector<Turn>& alg, unsigned int order) {
+            ResultRecord record;
+            record.kind = ResultRecord::RESULT;
+            record.threadNum = threadNum;
+            record.algNum = algNum;
+            record.order = order;
+            record.length = (unsigned int)alg.size();
+            if (format == BINARY) {
+                push(producer, record);
+                return;
+            }
+
+            size_t i = 0;
+            do {
+                size_t n = std::min(alg.size() - i, (size_t)ResultRecord::MAX_TURNS);
+                std::copy(alg.begin() + (long)i, alg.begin() + (long)(i + n), record.turns);
+                record.numTurns = (unsigned char)n;
+                i += n;
+                record.more = i < alg.size();
+                push(producer, record);
+                record.kind = ResultRecord::CONTINUATION;
+            } while (i < alg.size());
+        }
+
+        void pushHeartbeat(size_t producer, unsigned long long int algNum) {
+            ResultRecord record;
+            record.kind = ResultRecord::HEARTBEAT;
+            record.algNum = algNum;
+            push(producer, record);
+        }
+
+        void pushChunk(size_t producer, unsigned long long int chunk) {
+            ResultRecord record;
+            record.kind = ResultRecord::CHUNK;
+            record.algNum = chunk;
+            push(producer, record);
+        }
+
+        /**
+         * @brief Call listener from the writer thread after each write that
+         * succeeds. Must be set before anything is pushed.
+         */
+        void setFlushListener(FlushListener listener) {
+            flushListener = listener;
+        }
+
+        /**
+         * @brief Write the records of producers 0 through numProducers - 1
+         * a chunk at a time, in chunk index order, starting at chunk 0. Each
+         * of their records belongs to the chunk record that follows it. Must
+         * be called before anything is pushed.
+         */
+        void orderChunks(size_t numProducers) {
+            numOrdered = std::min(numProducers, rings.size());
+            open.resize(numOrdered);
+        }
+
+        /**
+         * @brief The lowest chunk index not yet written in order.
+         */
+        unsigned long long int getNextChunk() const {
+            return nextChunk.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief Write everything queued so far and stop the writer thread.
+         * No more records may be pushed afterwards.
+         */
+        void stop() {
+            if (!thread.joinable())
+                return;
+            stopping.store(true, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(wakeMutex);
+                wake.notify_one();
+            }
+            thread.join();
+        }
+
+    private:
+        /* What wakes the writer thread. */
+        enum Wakeup : unsigned char {AWAKE, ANY_RECORD, RING_FILLING};
+
+        std::vector<std::unique_ptr<SpscRing<ResultRecord>>> rings;
+        int fd;
+        std::chrono::milliseconds flushInterval;
+        Format format;
+        unsigned int layerDepth;
+        std::atomic<bool> stopping;
+        std::string buffer;
+        std::unique_ptr<ResultFileWriter> file;
+        FlushListener flushListener;
+        std::vector<unsigned long long int> flushedChunks;
+        std::vector<unsigned int> flushedOrders;
+        size_t numOrdered;
+        std::vector<std::vector<ResultRecord>> open; // Records of each ordered producer's current chunk.
+        std::map<unsigned long long int, std::vector<ResultRecord>> held; // Complete chunks.
+        std::atomic<unsigned long long int> nextChunk;
+        std::atomic<Wakeup> wakeup{AWAKE};
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        std::thread thread;
+
+        void push(size_t producer, const ResultRecord& record) {
+            SpscRing<ResultRecord>& ring = *rings.at(producer);
+            while (!ring.tryPush(record)) {
+                if (wakeup.load(std::memory_order_relaxed) != AWAKE)
+                    notify();
+                std::this_thread::yield();
+            }
+            /* Pairs with the fence in sleep, so either the writer sees this record or it is woken. */
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            Wakeup w = wakeup.load(std::memory_order_relaxed);
+            if (w == ANY_RECORD || (w == RING_FILLING && ring.sizeApprox() >= ring.capacity() / 2))
+                notify();
+        }
+
+        /* Taking the lock means the writer is either not yet checking the rings or waiting. */
+        void notify() {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            wake.notify_one();
+        }
+
+        /**
+         * Block until a record arrives, or with pending output until the flush
+         * is due or a ring is half full. Returns early if a producer pushed
+         * before the writer went to sleep.
+         */
+        void sleep(bool pending, std::chrono::steady_clock::time_point flushDue) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeup.store(pending ? RING_FILLING : ANY_RECORD, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool idle = !stopping.load(std::memory_order_acquire);
+            for (size_t r = 0; idle && r < rings.size(); r++)
+                idle = pending ? rings[r]->sizeApprox() < rings[r]->capacity() / 2
+                               : rings[r]->sizeApprox() == 0;
+            if (idle && pending)
+                wake.wait_until(lock, flushDue);
+            else if (idle)
+                wake.wait(lock);
+            wakeup.store(AWAKE, std::memory_order_relaxed);
+        }
+
+        void run() {
+            TraceRecorder::nameThread("writer");
+            auto oldest = std::chrono::steady_clock::now();
+            bool pending = !buffer.empty();
+            while (true) {
+                /* Read the flag first, so the final pass sees every record. */
+                bool done = stopping.load(std::memory_order_acquire);
+                bool drained = drain();
+                if (done)
+                    releaseHeld();
+                if (drained && !pending)
+                    oldest = std::chrono::steady_clock::now();
+                pending = pending || drained;
+
+                if (done || buffer.size() >= BUFFER_SIZE ||
+                    (pending && std::chrono::steady_clock::now() - oldest >= flushInterval)) {
+                    flush();
+                    pending = false;
+                }
+                if (done)
+                    return;
+                if (!drained)
+                    sleep(pending, oldest + flushInterval);
+            }
+        }
+
+        /* One pass over every ring. Returns true if anything was drained. */
+        bool drain() {
+            bool drained = false;
+            ResultRecord record;
+            for (size_t r = 0; r < rings.size(); r++) {
+                SpscRing<ResultRecord>& ring = *rings[r];
+                /* Bound the pass so one busy ring cannot starve the others. */
+                for (size_t n = ring.capacity(); n > 0 && ring.tryPop(record); n--) {
+                    accept(r, record);
+                    drained = true;
+                }
+                /* Never leave a result half written. */
+                while (record.more) {
+                    if (!ring.tryPop(record)) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    accept(r, record);
+                }
+            }
+            return drained;
+        }
+
+        void accept(size_t producer, const ResultRecord& record) {
+            if (producer >= numOrdered) {
+                formatRecord(record);
+                return;
+            }
+
+            open[producer].push_back(record);
+            if (record.kind != ResultRecord::CHUNK)
+                return;
+            held[record.algNum].swap(open[producer]);
+            open[producer].clear();
+
+            unsigned long long int next = nextChunk.load(std::memory_order_relaxed);
+            for (auto chunk = held.begin(); chunk != held.end() && chunk->first == next;
+                 chunk = held.erase(chunk), ++next)
+                for (const ResultRecord& r : chunk->second)
+                    formatRecord(r);
+            nextChunk.store(next, std::memory_order_release);
+        }
+
+        /**
+         * At the end, write whatever is still held: chunks after a gap left by
+         * a search that stopped early, then any unfinished chunks.
+         */
+        void releaseHeld() {
+            for (const std::pair<const unsigned long long int, std::vector<ResultRecord>>& chunk : held)
+                for (const ResultRecord& r : chunk.second)
+                    formatRecord(r);
+            held.clear();
+            for (std::vector<ResultRecord>& records : open) {
+                for (const ResultRecord& r : records)
+                    formatRecord(r);
+                records.clear();
+            }
+        }
+
+        void formatRecord(const ResultRecord& record) {
+            char field[64];
+            int n = 0;
+            if (record.kind == ResultRecord::CHUNK) {
+                if (flushListener)
+                    flushedChunks.push_back(record.algNum);
+                return;
+            } else if (record.kind == ResultRecord::RESULT && flushListener) {
+                flushedOrders.push_back(record.order);
+            }
+
+            if (file && record.kind == ResultRecord::HEARTBEAT) {
+                n = std::snprintf(field, sizeof(field), "HB:%llu\n", record.algNum);
+                writeAll(STDERR_FILENO, field, (size_t)n);
+                return;
+            } else if (file) {
+                file->add(record.algNum, record.order, record.length);
+                return;
+            }
+
+            if (record.kind == ResultRecord::HEARTBEAT)
+                n = std::snprintf(field, sizeof(field), "HB:%llu\n", record.algNum);
+            else if (record.kind == ResultRecord::RESULT)
+                n = std::snprintf(field, sizeof(field), "TN:%-5uAN:%-10lluOR:%-5uAG:",
+                                  record.threadNum, record.algNum, record.order);
+            buffer.append(field, (size_t)n);
+
+            for (unsigned int i = 0; i < record.numTurns; i++) {
+                buffer += Algorithm::turnToStr(record.turns[i]);
+                buffer += ' ';
+            }
+            if (record.kind != ResultRecord::HEARTBEAT && !record.more)
+                buffer += '\n';
+        }
+
+        void flush() {
+            TraceRecorder::Span span("flush", "output", "bytes", buffer.size());
+            if (file)
+                file->flushBlock();
+            bool written = writeAll(fd, buffer.data(), buffer.size());
+            buffer.clear();
+            if (written && flushListener && (!flushedChunks.empty() || !flushedOrders.empty()))
+                flushListener(flushedChunks, flushedOrders);
+            flushedChunks.clear();
+            flushedOrders.clear();
+        }
+
+        static bool writeAll(int fd, const char* data, size_t remaining) {
+            while (remaining > 0) {
+                ssize_t written = ::write(fd, data, remaining);
+                if (written < 0 && errno == EINTR)
+                    continue;
+                if (written <= 0)
+                    return false;
+                data += written;
+                remaining -= (size_t)written;
+            }
+            return true;
+        }
+};
+
+#endif // RESULTWRITER_H
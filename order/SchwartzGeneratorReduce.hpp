@@ -25,20 +25,40 @@
  * as provided by Professor Kevin Lundeen from Seattle University.
  */
 
+#include <algorithm>
 #include <future>
+#include <vector>
+
+#include "ThreadPool.hpp"
+#include "TraceRecorder.hpp"
 
 #ifndef SCHWARTZGENERATORREDUCE_H
 #define SCHWARTZGENERATORREDUCE_H
 
+/**
+ * The reduction is a binary tree stored in an array, with n_threads leaves.
+ * Each leaf accumulates one slice of [0, dataSize), and each interior node
+ * combines its two children. Slices are handed to the leaves in tree order
+ * (left to right), so combining children left then right keeps the data in
+ * index order for any number of leaves, not only powers of two. Slice sizes
+ * differ by at most one.
+ *
+ * Leaves, and then each level of interior nodes, run as tasks on a thread
+ * pool. Pass a pool to share it between reductions; otherwise one with
+ * n_threads workers is created for this reduction.
+ */
 template<typename TallyType, typename ResultType=TallyType>
 class SchwartzGeneratorReduce {
     public:
         typedef std::vector<TallyType*> TallyData;
         static const size_t ROOT = 0;
 
-        SchwartzGeneratorReduce(size_t n_threads, unsigned long long int dataSize) : 
-                        reduced(false), n_threads(n_threads), dataSize(dataSize) {
-            interior = new TallyData(n_threads * 2);
+        SchwartzGeneratorReduce(size_t n_threads, unsigned long long int dataSize, ThreadPool* pool = nullptr) : 
+                        reduced(false), n_threads(n_threads < 1 ? 1 : n_threads), dataSize(dataSize),
+                        pool(pool), ownedPool(nullptr) {
+            interior = new TallyData(this->n_threads * 2);
+            if (this->pool == nullptr)
+                this->pool = ownedPool = new ThreadPool(this->n_threads);
         }
 
         virtual ~SchwartzGeneratorReduce() {
@@ -47,10 +67,11 @@ class SchwartzGeneratorReduce {
                     delete t;
                 delete interior;
             }
+            delete ownedPool;
         }
 
         ResultType* getReduction() {
-            reduced = reduced || reduce(ROOT);
+            reduced = reduced || reduce();
             return gen(value(ROOT));
         }
 
@@ -81,33 +102,82 @@ class SchwartzGeneratorReduce {
          */
         virtual void accum(TallyType* accumulator, unsigned long long int index) const = 0;
 
+        /**
+         * Accumulate every index in [start, end). Each leaf makes one call, so
+         * overriding this moves the per index work out of virtual dispatch.
+         * By default, accum is called for each index.
+         */
+        virtual void accumRange(TallyType* accumulator, unsigned long long int start,
+                                unsigned long long int end) const {
+            for (unsigned long long int j = start; j < end; ++j)
+                accum(accumulator, j);
+        }
+
     private:
         TallyData* interior;
         bool reduced;
         size_t n_threads;
         unsigned long long int dataSize;
+        ThreadPool* pool;
+        ThreadPool* ownedPool;
 
         TallyType* value(size_t i) {
             return interior->at(i);
         }
 
-        bool reduce(size_t i) {
-            if (i < n_threads - 1) {
-                auto handle = std::async(std::launch::async, &SchwartzGeneratorReduce::reduce, this, right(i));
-                reduce(left(i));
-                handle.wait();
-                interior->at(i) = combine(value(left(i)), value(right(i)));
-            } else {
-                TallyType* tally = init();
-                unsigned long long int start = getStart(i);
-                unsigned long long int end = getEnd(start);
-                for (unsigned long long int j = start; j < end; ++j)
-                    accum(tally, j);
-                interior->at(i) = tally;
+        bool reduce() {
+            std::vector<std::future<void>> tasks;
+            std::vector<size_t> leaves;
+            getLeaves(ROOT, leaves);
+
+            for (size_t slice = 0; slice < leaves.size(); slice++)
+                tasks.push_back(pool->submit([this, &leaves, slice] {
+                    accumLeaf(leaves[slice], slice);
+                }));
+            wait(tasks);
+
+            /* Interior nodes, deepest level first. */
+            size_t levelStart = 0;
+            while (left(levelStart) < n_threads - 1)
+                levelStart = left(levelStart);
+            while (true) {
+                size_t levelEnd = std::min(left(levelStart), n_threads - 1);
+                for (size_t i = levelStart; i < levelEnd; i++)
+                    tasks.push_back(pool->submit([this, i] {
+                        TraceRecorder::Span span("combine", "reduce", "node", i);
+                        interior->at(i) = combine(value(left(i)), value(right(i)));
+                    }));
+                wait(tasks);
+                if (levelStart == ROOT)
+                    break;
+                levelStart = (levelStart - 1) / 2;
             }
             return true;
         }
 
+        void accumLeaf(size_t node, size_t slice) {
+            TraceRecorder::Span span("leaf", "reduce", "node", node);
+            TallyType* tally = init();
+            accumRange(tally, getStart(slice), getStart(slice + 1));
+            interior->at(node) = tally;
+        }
+
+        /* Leaves in left to right order. */
+        void getLeaves(size_t i, std::vector<size_t>& leaves) {
+            if (i >= n_threads - 1) {
+                leaves.push_back(i);
+                return;
+            }
+            getLeaves(left(i), leaves);
+            getLeaves(right(i), leaves);
+        }
+
+        void wait(std::vector<std::future<void>>& tasks) {
+            for (std::future<void>& task : tasks)
+                task.get();
+            tasks.clear();
+        }
+
         size_t left(size_t i) {
             return i * 2 + 1;
         }   
@@ -116,20 +186,10 @@ class SchwartzGeneratorReduce {
             return left(i) + 1;
         }
 
-        unsigned long long int getSize() {
+        unsigned long long int getStart(size_t slice) {
             unsigned long long int size = dataSize / n_threads;
-            if (size*n_threads != size)
-                ++size;
-            return size;
-        }
-
-        unsigned long long int getStart(size_t node) {
-            return (node - n_threads + 1)*getSize();
-        }
-
-        unsigned long long int getEnd(size_t start) {
-            unsigned long long int size = getSize();
-            return (start + size) > dataSize ? dataSize : start + size;
+            unsigned long long int remainder = dataSize % n_threads;
+            return slice*size + std::min((unsigned long long int)slice, remainder);
         }
 };
 
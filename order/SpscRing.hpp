@@ -0,0 +1,103 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    A bounded single producer, single consumer queue. One thread may push
+ *    and one other thread may pop without taking a lock. The head and tail
+ *    counters live on separate cache lines so the two sides do not contend.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+template<typename T>
+class SpscRing {
+    public:
+        /**
+         * @param capacity Rounded up to a power of two.
+         */
+        SpscRing(size_t capacity) : head(0), tail(0) {
+            size = 1;
+            while (size < capacity)
+                size <<= 1;
+            slots.reset(new T[size]);
+        }
+
+        SpscRing(const SpscRing&) = delete;
+        SpscRing& operator=(const SpscRing&) = delete;
+
+        /**
+         * @brief Producer side.
+         *
+         * @return false If the ring is full.
+         */
+        bool tryPush(const T& item) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            if (t - head.load(std::memory_order_acquire) == size)
+                return false;
+            slots[t & (size - 1)] = item;
+            tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Consumer side.
+         *
+         * @return false If the ring is empty.
+         */
+        bool tryPop(T& item) {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire))
+                return false;
+            item = slots[h & (size - 1)];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Items in the ring. Either side may ask; it is exact when the
+         * other side is not running.
+         */
+        size_t sizeApprox() const {
+            size_t h = head.load(std::memory_order_acquire);
+            return tail.load(std::memory_order_acquire) - h;
+        }
+
+        size_t capacity() const {
+            return size;
+        }
+
+    private:
+        alignas(64) std::atomic<size_t> head;
+        alignas(64) std::atomic<size_t> tail;
+        alignas(64) size_t size;
+        std::unique_ptr<T[]> slots;
+};
+
+#endif // SPSCRING_H
@@ -0,0 +1,111 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    A fixed set of worker threads that run submitted tasks in submission
+ *    order. The threads are started once and live as long as the pool, so the
+ *    pool can be shared by any number of reductions without paying for thread
+ *    creation each time.
+ *
+ *    Tasks must not wait on other tasks submitted to the same pool.
+ */
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+class ThreadPool {
+    public:
+        ThreadPool(size_t n_threads) : stopping(false) {
+            if (n_threads < 1)
+                n_threads = 1;
+            for (size_t i = 0; i < n_threads; i++)
+                workers.emplace_back(&ThreadPool::run, this);
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            ready.notify_all();
+            for (std::thread& t : workers)
+                t.join();
+        }
+
+        size_t size() const {
+            return workers.size();
+        }
+
+        /**
+         * @brief Queue a task for the next free worker.
+         *
+         * @return std::future<void> Becomes ready when the task has run.
+         */
+        std::future<void> submit(std::function<void()> task) {
+            std::packaged_task<void()> packaged(task);
+            std::future<void> done = packaged.get_future();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                tasks.push(std::move(packaged));
+            }
+            ready.notify_one();
+            return done;
+        }
+
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::packaged_task<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable ready;
+        bool stopping;
+
+        void run() {
+            while (true) {
+                std::packaged_task<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+                    if (tasks.empty())
+                        return;
+                    task = std::move(tasks.front());
+                    tasks.pop();
+                }
+                task();
+            }
+        }
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,201 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Records when each thread works on what, for --trace. A Span marks the
+ *    time between its construction and destruction, such as one chunk of a
+ *    search, one node of a reduction, or one write of the output. Spans are
+ *    written at exit as complete ("X") events in the Chrome trace JSON
+ *    format, which chrome://tracing and Perfetto open.
+ *
+ *    Each thread appends to its own buffer, so recording takes no lock. The
+ *    buffer is registered under a mutex the first time a thread records.
+ *    Buffers outlive their threads, and write must only be called once every
+ *    recording thread has finished.
+ *
+ *    Only one TraceRecorder may exist at a time. Without one, a Span costs a
+ *    load of the active recorder.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+class TraceRecorder {
+    public:
+        TraceRecorder() : start(std::chrono::steady_clock::now()) {
+            active.store(this, std::memory_order_release);
+        }
+
+        TraceRecorder(const TraceRecorder&) = delete;
+        TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+        ~TraceRecorder() {
+            active.store(nullptr, std::memory_order_release);
+        }
+
+        /**
+         * @brief Name the calling thread in the trace. Threads that are not
+         * named are shown by number.
+         */
+        static void nameThread(const std::string& name) {
+            TraceRecorder* recorder = active.load(std::memory_order_acquire);
+            if (recorder != nullptr)
+                recorder->getBuffer().name = name;
+        }
+
+        struct Event {
+            const char* name = nullptr;
+            const char* category = nullptr;
+            const char* argName = nullptr;
+            unsigned long long int arg = 0;
+            uint64_t start = 0; // ns since the recorder started.
+            uint64_t end = 0;
+        };
+
+        class Span {
+            public:
+                /**
+                 * @param name Shown on the span. Must outlive the recorder,
+                 * normally a string literal.
+                 * @param category Lets viewers filter spans. Also a literal.
+                 * @param argName Shown with arg when the span is selected, or
+                 * nullptr for no argument.
+                 */
+                Span(const char* name, const char* category, const char* argName = nullptr,
+                     unsigned long long int arg = 0) :
+                     recorder(active.load(std::memory_order_acquire)) {
+                    if (recorder == nullptr)
+                        return;
+                    event.name = name;
+                    event.category = category;
+                    event.argName = argName;
+                    event.arg = arg;
+                    event.start = recorder->now();
+                }
+
+                Span(const Span&) = delete;
+                Span& operator=(const Span&) = delete;
+
+                ~Span() {
+                    if (recorder == nullptr)
+                        return;
+                    event.end = recorder->now();
+                    recorder->getBuffer().events.push_back(event);
+                }
+
+            private:
+                TraceRecorder* recorder;
+                Event event;
+        };
+
+        /**
+         * @brief Write every recorded span to path.
+         * @throws std::runtime_error If the file can't be written.
+         */
+        void write(const std::string& path) {
+            std::ofstream out(path, std::ios::trunc);
+            if (!out)
+                throw std::runtime_error("Unable to write trace " + path);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            long pid = (long)::getpid();
+            const char* separator = "\n";
+            out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+            for (const std::unique_ptr<Buffer>& buffer : buffers) {
+                std::string name = buffer->name.empty() ?
+                                   "thread " + std::to_string(buffer->tid) : buffer->name;
+                out << separator << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+                    << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":\"" << name << "\"}}";
+                separator = ",\n";
+                for (const Event& event : buffer->events) {
+                    out << separator << "{\"name\":\"" << event.name << "\",\"cat\":\""
+                        << event.category << "\",\"ph\":\"X\",\"pid\":" << pid
+                        << ",\"tid\":" << buffer->tid << ",\"ts\":" << micros(event.start)
+                        << ",\"dur\":" << micros(event.end - event.start);
+                    if (event.argName != nullptr)
+                        out << ",\"args\":{\"" << event.argName << "\":" << event.arg << "}";
+                    out << "}";
+                }
+            }
+            out << "\n]}\n";
+            out.close();
+            if (!out)
+                throw std::runtime_error("Unable to write trace " + path);
+        }
+
+    private:
+        struct Buffer {
+            size_t tid;
+            std::string name;
+            std::vector<Event> events;
+        };
+
+        static const size_t INITIAL_EVENTS = 1024;
+
+        static inline std::atomic<TraceRecorder*> active{nullptr};
+        /* A thread's buffer, valid while the recorder it came from is active. */
+        static inline thread_local Buffer* threadBuffer = nullptr;
+        static inline thread_local TraceRecorder* threadRecorder = nullptr;
+
+        std::chrono::steady_clock::time_point start;
+        std::mutex mutex;
+        std::vector<std::unique_ptr<Buffer>> buffers;
+
+        uint64_t now() const {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+
+        Buffer& getBuffer() {
+            if (threadRecorder == this)
+                return *threadBuffer;
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.emplace_back(new Buffer());
+            threadBuffer = buffers.back().get();
+            threadBuffer->tid = buffers.size();
+            threadBuffer->events.reserve(INITIAL_EVENTS);
+            threadRecorder = this;
+            return *threadBuffer;
+        }
+
+        /* Microseconds with ns precision, as the format expects. */
+        static std::string micros(uint64_t ns) {
+            std::string digits = std::to_string(ns % 1000);
+            return std::to_string(ns / 1000) + "." + std::string(3 - digits.size(), '0') + digits;
+        }
+};
+
+#endif // TRACERECORDER_H
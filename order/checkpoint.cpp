@@ -0,0 +1,118 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    --checkpoint and --resume: snapshots of the range search's progress,
+ *    and restoring one before the search starts.
+ */
+
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cli.hpp"
+
+void recordFlushed(const std::vector<unsigned long long int>& chunks, const std::vector<unsigned int>& orders) {
+    std::lock_guard<std::mutex> lock(progressMutex);
+    for (unsigned long long int chunk : chunks)
+        completedChunks->mark(chunk);
+    for (unsigned int order : orders)
+        if (skipFoundOrders && order < writtenOrders.size())
+            writtenOrders[order] = true;
+}
+
+Checkpoint takeCheckpoint() {
+    Checkpoint checkpoint(ORDER_MAX);
+    checkpoint.startAlgorithm = initialAlgorithm.getAlgorithmStr();
+    checkpoint.count = algorithmCountMax;
+    checkpoint.chunkSize = chunkSize;
+    checkpoint.shard = std::to_string(shardIndex) + "/" + std::to_string(shardCount);
+
+    /* Hold every lock that publishes progress, so the snapshot is consistent. */
+    std::vector<std::unique_lock<std::mutex>> locks;
+    for (unsigned int i=0; histogram && i<numThreads; i++)
+        locks.emplace_back(histogramLocks[i]);
+    std::lock_guard<std::mutex> lock(progressMutex);
+
+    checkpoint.watermark = completedChunks->getWatermark();
+    checkpoint.completed = completedChunks->getMarkedAbove(checkpoint.watermark);
+    for (unsigned int order = 0; order < writtenOrders.size(); order++) {
+        if (writtenOrders[order])
+            checkpoint.found.push_back(order);
+        else if (skipFoundOrders && foundOrders->getOwnBest(order) != FoundOrders::NO_ALGORITHM)
+            checkpoint.best.emplace_back(order, foundOrders->getOwnBest(order));
+    }
+    for (OrderHistogram* h : histograms)
+        checkpoint.histogram.merge(*h);
+    return checkpoint;
+}
+
+int restoreCheckpoint(const char* path) {
+    /* Killed before the first checkpoint, so start from the beginning. */
+    if (access(path, F_OK) != 0) {
+        std::cerr << "No checkpoint at " << path << ", starting from the beginning" << std::endl;
+        return 0;
+    }
+
+    Checkpoint checkpoint(ORDER_MAX);
+    try {
+        checkpoint.load(path);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    if (checkpoint.startAlgorithm != initialAlgorithm.getAlgorithmStr() ||
+        checkpoint.count != algorithmCountMax || checkpoint.chunkSize != chunkSize ||
+        checkpoint.shard != std::to_string(shardIndex) + "/" + std::to_string(shardCount)) {
+        std::cerr << "Checkpoint " << path << " is for a different search: --algstart \""
+                  << checkpoint.startAlgorithm << "\" --count " << checkpoint.count
+                  << " --chunk-size " << checkpoint.chunkSize
+                  << " --shard " << checkpoint.shard << std::endl;
+        return 1;
+    }
+
+    for (unsigned long long int chunk = 0; chunk < checkpoint.watermark; chunk++)
+        completedChunks->mark(chunk);
+    for (unsigned long long int chunk : checkpoint.completed)
+        completedChunks->mark(chunk);
+    for (unsigned int order : checkpoint.found) {
+        if (!skipFoundOrders || order >= writtenOrders.size())
+            continue;
+        writtenOrders[order] = true;
+        foundOrders->report(order);
+    }
+    for (const std::pair<unsigned int, unsigned long long int>& best : checkpoint.best)
+        if (skipFoundOrders && best.first < writtenOrders.size() && !writtenOrders[best.first])
+            foundOrders->claim(best.first, best.second);
+    if (histogram)
+        histograms[0]->merge(checkpoint.histogram);
+
+    std::cerr << "Resuming at chunk " << checkpoint.watermark << " of "
+              << completedChunks->getNumChunks() << std::endl;
+    return 0;
+}
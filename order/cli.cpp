@@ -22,18 +22,38 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <cstring>
+#include <fcntl.h>
 #include <chrono>
 #include <getopt.h>
 #include <iostream>
 #include <iomanip>
 #include <map>
 #include <mutex>
+#include <sstream>
 #include <thread>
+#include <unistd.h>
 #include <vector>
 
+#include "AlgorithmInput.hpp"
 #include "AlgorithmTally.hpp"
+#include "Checkpoint.hpp"
+#include "CubeOrders.hpp"
+#include "FoundOrders.hpp"
+#include "Monitor.hpp"
+#include "PhaseProfile.hpp"
+#include "TraceRecorder.hpp"
+#include "OrderDatabase.hpp"
+#include "OrderHistogram.hpp"
+#include "RangeScheduler.hpp"
+#include "ResultFile.hpp"
+#include "ResultWriter.hpp"
 #include "SchwartzGeneratorReduce.hpp"
+#include "ThreadPool.hpp"
+#include "cli.hpp"
 #include "../Cube.hpp"
 #include "../Algorithm.hpp"
 
@@ -43,24 +63,58 @@ int allOrders[] = {2,3,4,5,6,7,8,9,10,11,12,14,15,16,18,20,21,22,24,28,30,33,
                    240,252,280,315,330,336,360,420,462,495,504,630,720,840,990,
                    1260};
 
-std::mutex coutMutex;
 std::string findOrders;
-std::vector<bool> foundOrders;
 unsigned long long int skip_nth;
 unsigned long long int algorithmCountMax;
-unsigned long long int numSkipFoundOrders;
 unsigned long long int heartbeat;
+unsigned long long int chunkSize;
+unsigned long long int flushMs;
+unsigned long long int checkpointInterval;
+unsigned long long int shardIndex;
+unsigned long long int shardCount;
+unsigned long long int shardStart;
+unsigned long long int shardEnd;
+unsigned int coordinatorWorkers;
+bool pinWorkers;
+unsigned long long int workerTimeout;
+bool orderedOutput;
+unsigned long long int progressInterval;
+bool pipeline;
+unsigned int pipelineFilters;
+unsigned int pipelineEvaluators;
 unsigned int numThreads;
 unsigned int foundOrder;
 bool keepDuplicates;
 bool skipFoundOrders;
+bool reportLowest; // Report the lowest algorithm of each found order.
 bool showFoundOrder;
+bool histogram;
+bool histogramByLength;
 Algorithm initialAlgorithm;
+FoundOrders* foundOrders;
+RangeScheduler* scheduler;
+ResultWriter* writer;
+ResultWriter::Format outputFormat;
+std::vector<OrderHistogram*> histograms;
+OrderDatabase* orderDatabase;
+AlgorithmInput::Format inputFormat;
+ChunkSet* completedChunks;
+std::mutex* histogramLocks;
+std::mutex progressMutex;
+std::mutex reportMutex;
+std::vector<bool> writtenOrders;
+ThreadCounters* counters;
 
 const size_t COLUMN_WIDTH = 20;
 const long long int ORDER_11 = 6501631764;
 const long long int DEFAULT_ALG_MAX = ORDER_11;
-const int ORDER_MAX = 1261;
+const unsigned long long int DEFAULT_CHUNK_SIZE = 4096;
+const unsigned long long int DEFAULT_FLUSH_MS = 100;
+const unsigned int DEFAULT_DB_LENGTH = 6;
+const unsigned long long int DEFAULT_CHECKPOINT_INTERVAL = 60;
+const unsigned long long int DEFAULT_WORKER_TIMEOUT = 600;
+const unsigned long long int ORDERED_CHUNKS_PER_THREAD = 2;
+const unsigned long long int DEFAULT_PROGRESS_INTERVAL = 10;
 
 static struct option longopts[] = {
     {"algstart",     required_argument, nullptr, 'a'},
@@ -70,6 +124,30 @@ static struct option longopts[] = {
     {"algbenchlite", no_argument,       nullptr, 'e'},
     {"count",        required_argument, nullptr, 'c'},
     {"heartbeat",    required_argument, nullptr, 'b'},
+    {"chunk-size",   required_argument, nullptr, 'z'},
+    {"flush-ms",     required_argument, nullptr, 'w'},
+    {"output-format", required_argument, nullptr, 'r'},
+    {"dump-results", required_argument, nullptr, 'd'},
+    {"histogram",    optional_argument, nullptr, 'm'},
+    {"build-db",     required_argument, nullptr, 'B'},
+    {"db-length",    required_argument, nullptr, 'L'},
+    {"db",           required_argument, nullptr, 'D'},
+    {"lookup",       required_argument, nullptr, 'q'},
+    {"input",        required_argument, nullptr, 'I'},
+    {"input-format", required_argument, nullptr, 'n'},
+    {"checkpoint",   required_argument, nullptr, 'K'},
+    {"checkpoint-interval", required_argument, nullptr, 'T'},
+    {"resume",       no_argument,       nullptr, 'R'},
+    {"shard",        required_argument, nullptr, 'S'},
+    {"coordinator",  required_argument, nullptr, 'C'},
+    {"pin",          no_argument,       nullptr, 'P'},
+    {"worker-timeout", required_argument, nullptr, 'W'},
+    {"share-found",  required_argument, nullptr, 'F'},
+    {"pipeline",     optional_argument, nullptr, 'Q'},
+    {"ordered",      no_argument,       nullptr, 'O'},
+    {"progress",     optional_argument, nullptr, 'G'},
+    {"metrics",      required_argument, nullptr, 'M'},
+    {"trace",        required_argument, nullptr, 'E'},
     {"keep-dupes",   no_argument,       nullptr, 'k'},
     {"skip-nth",     required_argument, nullptr, 's'},
     {"threads",      required_argument, nullptr, 't'},
@@ -82,15 +160,32 @@ static struct option longopts[] = {
 
 void setFindAllOrders();
 void setFindOrders(char* findOrders);
+bool setShard(const char* shard);
+bool setPipeline(const char* stages);
+void describeSearch();
 void usage(char* progName);
 void doAlgBench(bool lite);
-void doAlgReduce(unsigned long long int algs, bool (Algorithm::*algEval)());
-void calculateOrder(const unsigned int threadNum);
-void printResult(const unsigned int threadNum, const unsigned long long int algNum, const std::vector<Turn> &alg, const unsigned int order);
+int dumpResults(const char* path);
+int lookupOrder(const char* algorithm);
+template<RedundancyEvaluator RE> void doAlgReduce(unsigned long long int algs, ThreadPool* pool);
+Monitor* startMonitor(const unsigned long long int resumed, const char* metricsPath);
+bool waitForChunk(const unsigned int threadNum, const RangeScheduler::Range& range);
+void completeChunk(const unsigned int threadNum, const unsigned long long int chunk, OrderHistogram* chunkHistogram);
 
 int main(int argc, char *argv[]) {
     int ch;
     char* algorithmStart = nullptr;
+    char* dumpPath = nullptr;
+    char* buildDbPath = nullptr;
+    char* dbPath = nullptr;
+    char* lookupAlgorithm = nullptr;
+    char* inputPath = nullptr;
+    char* checkpointPath = nullptr;
+    char* sharedFoundPath = nullptr;
+    char* metricsPath = nullptr;
+    char* tracePath = nullptr;
+    bool resume = false;
+    unsigned int dbLength = DEFAULT_DB_LENGTH;
     unsigned long long int algmathAddVal = 0;
     char* algmathLtVal = nullptr;
     bool algmathAdd = false;
@@ -100,13 +195,32 @@ int main(int argc, char *argv[]) {
     algorithmCountMax = DEFAULT_ALG_MAX;
     keepDuplicates = false;
     skipFoundOrders = false;
+    reportLowest = true;
     showFoundOrder = false;
+    histogram = false;
+    histogramByLength = false;
     skip_nth = 1;
     heartbeat = 0;
+    chunkSize = DEFAULT_CHUNK_SIZE;
+    flushMs = DEFAULT_FLUSH_MS;
+    checkpointInterval = DEFAULT_CHECKPOINT_INTERVAL;
+    shardIndex = 0;
+    shardCount = 1;
+    coordinatorWorkers = 0;
+    pinWorkers = false;
+    workerTimeout = DEFAULT_WORKER_TIMEOUT;
+    orderedOutput = false;
+    progressInterval = 0;
+    pipeline = false;
+    pipelineFilters = 0;
+    pipelineEvaluators = 0;
+    bool threadsSet = false;
+    outputFormat = ResultWriter::TEXT;
+    inputFormat = AlgorithmInput::TEXT;
     numThreads = std::thread::hardware_concurrency();
 
     opterr = 0;
-    while((ch = getopt_long(argc, argv, "a:gep:l:c:b:ks:t:f:o:ih", longopts, NULL)) != -1) {
+    while((ch = getopt_long(argc, argv, "a:gep:l:c:b:z:w:r:d:m::B:L:D:q:I:n:K:T:RS:C:PW:F:Q::OG::M:E:ks:t:f:o:ih", longopts, NULL)) != -1) {
         switch(ch) {
             case 'a':
                 algorithmStart = optarg;
@@ -132,6 +246,102 @@ int main(int argc, char *argv[]) {
             case 'b':
                 heartbeat = (unsigned long long int)(std::strtoll(optarg, nullptr, 10));
                 break;
+            case 'z':
+                chunkSize = (unsigned long long int)(std::strtoll(optarg, nullptr, 10));
+                break;
+            case 'w':
+                flushMs = (unsigned long long int)(std::strtoll(optarg, nullptr, 10));
+                break;
+            case 'r':
+                if (std::string(optarg) == "binary") {
+                    outputFormat = ResultWriter::BINARY;
+                } else if (std::string(optarg) != "text") {
+                    usage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'd':
+                dumpPath = optarg;
+                break;
+            case 'B':
+                buildDbPath = optarg;
+                break;
+            case 'L':
+                dbLength = (unsigned int)std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'D':
+                dbPath = optarg;
+                break;
+            case 'q':
+                lookupAlgorithm = optarg;
+                break;
+            case 'I':
+                inputPath = optarg;
+                break;
+            case 'n':
+                if (std::string(optarg) == "binary") {
+                    inputFormat = AlgorithmInput::BINARY;
+                } else if (std::string(optarg) != "text") {
+                    usage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'K':
+                checkpointPath = optarg;
+                break;
+            case 'T':
+                checkpointInterval = (unsigned long long int)(std::strtoll(optarg, nullptr, 10));
+                break;
+            case 'R':
+                resume = true;
+                break;
+            case 'S':
+                if (!setShard(optarg)) {
+                    usage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'C':
+                coordinatorWorkers = (unsigned int)std::strtoul(optarg, nullptr, 10);
+                break;
+            case 'P':
+                pinWorkers = true;
+                break;
+            case 'W':
+                workerTimeout = (unsigned long long int)(std::strtoll(optarg, nullptr, 10));
+                break;
+            case 'F':
+                sharedFoundPath = optarg;
+                break;
+            case 'O':
+                orderedOutput = true;
+                break;
+            case 'G':
+                progressInterval = DEFAULT_PROGRESS_INTERVAL;
+                if (optarg != nullptr)
+                    progressInterval = (unsigned long long int)(std::strtoll(optarg, nullptr, 10));
+                break;
+            case 'M':
+                metricsPath = optarg;
+                break;
+            case 'E':
+                tracePath = optarg;
+                break;
+            case 'Q':
+                if (!setPipeline(optarg)) {
+                    usage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'm':
+                histogram = true;
+                if (optarg != nullptr && std::string(optarg) == "lengths") {
+                    histogramByLength = true;
+                } else if (optarg != nullptr && std::string(optarg) != "orders") {
+                    usage(argv[0]);
+                    return 0;
+                }
+                break;
             case 'k':
                 keepDuplicates = true;
                 break;
@@ -141,6 +351,7 @@ int main(int argc, char *argv[]) {
                 break;
             case 't':
                 numThreads = (unsigned int)std::stoul(optarg, nullptr, 10);
+                threadsSet = true;
                 break;
             case 'i':
                 setFindAllOrders();
@@ -152,7 +363,7 @@ int main(int argc, char *argv[]) {
                 showFoundOrder = true;
                 try {
                     foundOrder = (unsigned int)std::stoul(optarg, nullptr, 10);
-                } catch (std::invalid_argument) {
+                } catch (const std::invalid_argument&) {
                     usage(argv[0]);
                     return 0;
                 }
@@ -167,15 +378,67 @@ int main(int argc, char *argv[]) {
 
     if (skip_nth == 0)
         skip_nth = 1;
+    if (metricsPath != nullptr && progressInterval == 0)
+        progressInterval = DEFAULT_PROGRESS_INTERVAL;
+    if (coordinatorWorkers > 0 && !threadsSet)
+        numThreads = 1;
+    if (pipelineFilters > 0)
+        numThreads = pipelineFilters + pipelineEvaluators;
     if (numThreads < 1)
         numThreads = 1;
+    if (chunkSize < 1)
+        chunkSize = 1;
     std::vector<std::thread> threads(numThreads);
 
     initialAlgorithm.reset();
     if (algorithmStart != nullptr)
         initialAlgorithm.setAlgorithm(algorithmStart);
 
-    if (algmathAdd) {
+    if (resume && checkpointPath == nullptr) {
+        std::cerr << "--resume needs --checkpoint." << std::endl;
+        return 1;
+    }
+
+    if (sharedFoundPath != nullptr && !skipFoundOrders) {
+        std::cerr << "--share-found needs --find-orders or --find-all." << std::endl;
+        return 1;
+    } else if (sharedFoundPath != nullptr) {
+        try {
+            foundOrders->share(sharedFoundPath);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (dbPath != nullptr) {
+        try {
+            orderDatabase = new OrderDatabase(dbPath);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    TraceRecorder* tracer = tracePath != nullptr ? new TraceRecorder() : nullptr;
+
+    if (dumpPath != nullptr) {
+        return dumpResults(dumpPath);
+    } else if (buildDbPath != nullptr) {
+        std::cerr << "Building order database of algorithms up to length "
+                  << dbLength << " (" << OrderDatabase::getNumAlgorithms(dbLength)
+                  << " algorithms)..." << std::endl;
+        try {
+            OrderDatabase::build(buildDbPath, dbLength, numThreads);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+    } else if (lookupAlgorithm != nullptr) {
+        int status = lookupOrder(lookupAlgorithm);
+        delete orderDatabase;
+        return status;
+    } else if (algmathAdd) {
         Algorithm endAlgorithm(initialAlgorithm);
         endAlgorithm += algmathAddVal;
         std::cout << endAlgorithm.getAlgorithmStr() << std::endl;
@@ -188,35 +451,144 @@ int main(int argc, char *argv[]) {
     } else if (algBench) {
         std::cerr << "Threads: " << numThreads << std::endl;
         doAlgBench(algBenchLite);
-    } else {
-        std::cerr << "Algorithm Count: " << algorithmCountMax << std::endl;
-        std::cerr << "Algorithm Start: " << initialAlgorithm.getAlgorithmStr() << std::endl;
-
+    } else if (inputPath != nullptr) {
+        std::cerr << "Input: " << inputPath << std::endl;
         if (skipFoundOrders)
             std::cerr << "Finding Orders: " << findOrders << std::endl;
         std::cerr << "Threads: " << numThreads << std::endl;
-   
+
+        /* Input is reported in input order, which is already deterministic. */
+        reportLowest = false;
+        /* Input algorithm numbers count from F, not from --algstart. */
+        writer = new ResultWriter(1, STDOUT_FILENO, flushMs, outputFormat, Algorithm());
+        if (histogram)
+            histograms.push_back(new OrderHistogram(ORDER_MAX));
+        int status = evaluateInput(inputPath);
+        delete writer;
+
+        if (histogram) {
+            printHistogram(*histograms[0]);
+            delete histograms[0];
+        }
+        if (status != 0)
+            return status;
+    } else if (coordinatorWorkers > 0) {
+        if (outputFormat == ResultWriter::BINARY || checkpointPath != nullptr) {
+            std::cerr << "--coordinator writes text output and does not checkpoint." << std::endl;
+            return 1;
+        }
+        if (pipeline || orderedOutput) {
+            std::cerr << "--coordinator workers do not run a pipeline or order output." << std::endl;
+            return 1;
+        }
+        describeSearch();
+        std::cerr << "Worker Processes: " << coordinatorWorkers << std::endl;
+        int status = coordinate(coordinatorWorkers, pinWorkers);
+        if (status != 0)
+            return status;
+        if (heartbeat > 0)
+            std::cout << "HB:-1" << std::endl;
+    } else if (pipeline) {
+        if (checkpointPath != nullptr || orderedOutput) {
+            std::cerr << "--pipeline does not checkpoint or order output." << std::endl;
+            return 1;
+        }
+        describeSearch();
+        if (pipelineFilters > 0)
+            std::cerr << "Pipeline: " << pipelineFilters << " filter and "
+                      << pipelineEvaluators << " evaluator threads" << std::endl;
+        Monitor* monitor = startMonitor(0, metricsPath);
+        runPipeline();
+        delete monitor;
+        delete[] counters;
+        if (heartbeat > 0 && outputFormat == ResultWriter::BINARY)
+            std::cerr << "HB:-1" << std::endl;
+        else if (heartbeat > 0)
+            std::cout << "HB:-1" << std::endl;
+    } else {
+        describeSearch();
+
+        scheduler = new RangeScheduler(numThreads, shardStart, shardEnd, chunkSize);
+        completedChunks = new ChunkSet(scheduler->getNumChunks());
+        histogramLocks = new std::mutex[numThreads];
+        writtenOrders.assign(ORDER_MAX, false);
+        for (unsigned int i=0; histogram && i<numThreads; i++)
+            histograms.push_back(new OrderHistogram(ORDER_MAX));
+        if (resume && restoreCheckpoint(checkpointPath) != 0)
+            return 1;
+
+        /* The extra producer is for reportFound. */
+        writer = new ResultWriter(numThreads + 1, STDOUT_FILENO, flushMs, outputFormat,
+                                  initialAlgorithm);
+        /* A histogram has no per-chunk output to order. */
+        if (histogram)
+            orderedOutput = false;
+        if (orderedOutput)
+            writer->orderChunks(numThreads);
+        Checkpointer* checkpointer = nullptr;
+        if (checkpointPath != nullptr) {
+            writer->setFlushListener(recordFlushed);
+            checkpointer = new Checkpointer(checkpointPath, checkpointInterval, takeCheckpoint);
+        }
+        unsigned long long int resumed = 0;
+        for (unsigned long long int chunk = 0; resume && chunk < completedChunks->getNumChunks(); chunk++)
+            if (completedChunks->isMarked(chunk))
+                resumed += scheduler->getStart(chunk + 1) - scheduler->getStart(chunk);
+        Monitor* monitor = startMonitor(resumed, metricsPath);
+        PROFILE_START(numThreads);
         for (unsigned int i=0; i<numThreads; i++)
             threads.at(i) = std::thread(calculateOrder, i);
         for (std::thread &t : threads)
             t.join();
+        PROFILE_PRINT(std::cerr);
+        delete monitor;
+        delete[] counters;
+        if (skipFoundOrders)
+            reportFound(0, FoundOrders::NO_ALGORITHM, true);
+        delete writer;
+        if (checkpointer != nullptr) {
+            checkpointer->save();
+            delete checkpointer;
+        }
+        delete scheduler;
+        delete completedChunks;
+        delete[] histogramLocks;
 
-        if (heartbeat > 0)
+        if (histogram) {
+            printHistogram(takeHistogram());
+        }
+
+        if (heartbeat > 0 && outputFormat == ResultWriter::BINARY)
+            std::cerr << "HB:-1" << std::endl;
+        else if (heartbeat > 0)
             std::cout << "HB:-1" << std::endl;
     }
-    
+
+    /* Every traced thread has finished by now. */
+    if (tracer != nullptr) {
+        try {
+            tracer->write(tracePath);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            delete tracer;
+            return 1;
+        }
+        delete tracer;
+    }
+
+    delete foundOrders;
+    delete orderDatabase;
     return 0;
 }
 
 void setFindAllOrders() {
     skipFoundOrders = true;
-    numSkipFoundOrders = 0;
     findOrders = "";
 
-    for (int i = 0; i < ORDER_MAX; i++)
-        foundOrders.push_back(true);
+    delete foundOrders;
+    foundOrders = new FoundOrders(ORDER_MAX, true);
     for (int order : allOrders) {
-        foundOrders[(size_t)order] = false;
+        foundOrders->markWanted((size_t)order);
         findOrders += std::to_string(order) +  ",";
     }
     findOrders.pop_back();
@@ -225,15 +597,11 @@ void setFindAllOrders() {
 void setFindOrders(char* orderList) {
     std::string temp = "";
     skipFoundOrders = true;
-    numSkipFoundOrders = 0;
 
-    bool foundDefault = true;
-    if (orderList == NULL || strlen(orderList) == 0) {
-        foundDefault = false;
-        numSkipFoundOrders = ORDER_MAX;
-    }
-    for (int i = 0; i < ORDER_MAX; i++)
-        foundOrders.push_back(foundDefault);
+    /* An empty list wants every order, so the search never stops early. */
+    bool foundDefault = orderList != NULL && strlen(orderList) > 0;
+    delete foundOrders;
+    foundOrders = new FoundOrders(ORDER_MAX, foundDefault);
 
     unsigned int currOrder = 0;
     if (orderList == NULL)
@@ -242,9 +610,8 @@ void setFindOrders(char* orderList) {
     for (char c : std::string(orderList)) {
         temp += c;
         if (c == ',' && currOrder > 0 && currOrder < ORDER_MAX) {
-            foundOrders[currOrder] = false;
+            foundOrders->markWanted(currOrder);
             currOrder = 0;
-            ++numSkipFoundOrders;
             findOrders += temp;
             temp = "";
         } else if (c == ',') {
@@ -259,8 +626,7 @@ void setFindOrders(char* orderList) {
 
     nolist:
     if (currOrder < ORDER_MAX) {
-        foundOrders[currOrder] = false;
-        ++numSkipFoundOrders;
+        foundOrders->markWanted(currOrder);
         findOrders += temp;
     }
 
@@ -271,6 +637,66 @@ void setFindOrders(char* orderList) {
         findOrders = "1 - " + std::to_string(ORDER_MAX - 1);
 }
 
+/**
+ * Parse "i/N". Returns false unless 0 <= i < N.
+ */
+bool setShard(const char* shard) {
+    char* end;
+    unsigned long long int index = std::strtoull(shard, &end, 10);
+    if (end == shard || *end != '/')
+        return false;
+    const char* countStr = end + 1;
+    unsigned long long int count = std::strtoull(countStr, &end, 10);
+    if (end == countStr || *end != '\0' || index >= count)
+        return false;
+
+    shardIndex = index;
+    shardCount = count;
+    return true;
+}
+
+/**
+ * Parse the optional "F:E" thread counts of --pipeline.
+ */
+bool setPipeline(const char* stages) {
+    pipeline = true;
+    if (stages == nullptr)
+        return true;
+
+    char* end;
+    unsigned long long int filters = std::strtoull(stages, &end, 10);
+    if (end == stages || *end != ':')
+        return false;
+    const char* evaluatorsStr = end + 1;
+    unsigned long long int evaluators = std::strtoull(evaluatorsStr, &end, 10);
+    if (end == evaluatorsStr || *end != '\0' || filters < 1 || evaluators < 1)
+        return false;
+
+    pipelineFilters = (unsigned int)filters;
+    pipelineEvaluators = (unsigned int)evaluators;
+    return true;
+}
+
+/**
+ * Work out this shard's slice of the range and describe the search on stderr.
+ * Slice i of N gets count/N algorithms, and the first count%N slices one more.
+ */
+void describeSearch() {
+    unsigned long long int base = algorithmCountMax / shardCount;
+    unsigned long long int extra = algorithmCountMax % shardCount;
+    shardStart = shardIndex*base + std::min(shardIndex, extra);
+    shardEnd = shardStart + base + (shardIndex < extra ? 1 : 0);
+
+    std::cerr << "Algorithm Count: " << algorithmCountMax << std::endl;
+    std::cerr << "Algorithm Start: " << initialAlgorithm.getAlgorithmStr() << std::endl;
+    if (shardCount > 1)
+        std::cerr << "Shard: " << shardIndex << "/" << shardCount << " (algorithms "
+                  << shardStart << " to " << shardEnd << ")" << std::endl;
+    if (skipFoundOrders)
+        std::cerr << "Finding Orders: " << findOrders << std::endl;
+    std::cerr << "Threads: " << numThreads << std::endl;
+}
+
 void usage(char* progName) {
     std::cerr << "usage: " << progName << " "
               << "[--algstart | -a] "
@@ -279,6 +705,30 @@ void usage(char* progName) {
               << "[--algbenchlite | -e] "
               << "[--count | -c] "
               << "[--heartbeat | -b] "
+              << "[--chunk-size | -z] "
+              << "[--flush-ms | -w] "
+              << "[--output-format | -r] "
+              << "[--dump-results | -d] "
+              << "[--histogram | -m] "
+              << "[--build-db | -B] "
+              << "[--db-length | -L] "
+              << "[--db | -D] "
+              << "[--lookup | -q] "
+              << "[--input | -I] "
+              << "[--input-format | -n] "
+              << "[--checkpoint | -K] "
+              << "[--checkpoint-interval | -T] "
+              << "[--resume | -R] "
+              << "[--shard | -S] "
+              << "[--coordinator | -C] "
+              << "[--pin | -P] "
+              << "[--worker-timeout | -W] "
+              << "[--share-found | -F] "
+              << "[--pipeline | -Q] "
+              << "[--ordered | -O] "
+              << "[--progress | -G] "
+              << "[--metrics | -M] "
+              << "[--trace | -E] "
               << "[--keep-dupes | -k] "
               << "[--skip-nth | -s] "
               << "[--threads | -t] "
@@ -305,6 +755,110 @@ void usage(char* progName) {
     std::cerr << " [--heartbeat | -b]    - Display a heartbeat during --find-orders,"
               << " equivalent to every" << std::endl;
     std::cerr << "                         arg attempts." << std::endl;
+    std::cerr << " [--chunk-size | -z]   - The number of consecutive algorithms a "
+              << "thread takes at a" << std::endl;
+    std::cerr << "                         time. Default is "
+              << DEFAULT_CHUNK_SIZE << "." << std::endl;
+    std::cerr << " [--flush-ms | -w]     - The longest time in milliseconds that "
+              << "results are held" << std::endl;
+    std::cerr << "                         before being written. 0 writes "
+              << "them as soon as" << std::endl;
+    std::cerr << "                         possible. Default is "
+              << DEFAULT_FLUSH_MS << "." << std::endl;
+    std::cerr << " [--output-format | -r] - \"text\" (default) or \"binary\". Binary "
+              << "output is a" << std::endl;
+    std::cerr << "                         columnar result file, and heartbeats "
+              << "go to stderr." << std::endl;
+    std::cerr << " [--dump-results | -d] - Print a binary result file as text."
+              << std::endl;
+    std::cerr << " [--histogram | -m]    - Print only the number of algorithms of "
+              << "each order." << std::endl;
+    std::cerr << "                         --histogram=lengths also breaks the "
+              << "counts down by" << std::endl;
+    std::cerr << "                         algorithm length. Find options are "
+              << "ignored." << std::endl;
+    std::cerr << " [--build-db | -B]     - Write the order of every non-redundant "
+              << "algorithm up to" << std::endl;
+    std::cerr << "                         --db-length turns to an order database "
+              << "file." << std::endl;
+    std::cerr << " [--db-length | -L]    - The longest algorithm in a new order "
+              << "database. Default" << std::endl;
+    std::cerr << "                         is " << DEFAULT_DB_LENGTH << "."
+              << std::endl;
+    std::cerr << " [--db | -D]           - Look orders up in this order database "
+              << "before computing" << std::endl;
+    std::cerr << "                         them." << std::endl;
+    std::cerr << " [--lookup | -q]       - Print the order of one algorithm from "
+              << "--db." << std::endl;
+    std::cerr << " [--input | -I]        - Calculate the order of each algorithm in "
+              << "this file (\"-\"" << std::endl;
+    std::cerr << "                         for stdin) instead of counting from "
+              << "--algstart. Results" << std::endl;
+    std::cerr << "                         are in input order, AN: is the "
+              << "algorithm number, and" << std::endl;
+    std::cerr << "                         redundant algorithms are kept. "
+              << "--chunk-size sets the batch size." << std::endl;
+    std::cerr << " [--input-format | -n] - \"text\" (default), one algorithm per "
+              << "line, or \"binary\"," << std::endl;
+    std::cerr << "                         host order u64 algorithm numbers."
+              << std::endl;
+    std::cerr << " [--checkpoint | -K]   - Save the progress of the search to "
+              << "this file every" << std::endl;
+    std::cerr << "                         --checkpoint-interval seconds and "
+              << "when it ends." << std::endl;
+    std::cerr << " [--checkpoint-interval | -T] - Seconds between checkpoints. "
+              << "Default is " << DEFAULT_CHECKPOINT_INTERVAL << "." << std::endl;
+    std::cerr << " [--resume | -R]       - Continue the search saved in --checkpoint. "
+              << "Give the same" << std::endl;
+    std::cerr << "                         search options as before and append "
+              << "the output to the" << std::endl;
+    std::cerr << "                         old output (>>). Binary output "
+              << "starts a new result file." << std::endl;
+    std::cerr << " [--shard | -S]        - \"i/N\" searches only slice i (from 0) "
+              << "of N equal slices" << std::endl;
+    std::cerr << "                         of --count. AN: numbers stay relative "
+              << "to --algstart, so" << std::endl;
+    std::cerr << "                         merge can combine the outputs of "
+              << "every slice." << std::endl;
+    std::cerr << " [--coordinator | -C]  - Search with this many worker processes, "
+              << "each running" << std::endl;
+    std::cerr << "                         --threads threads (default 1). Ranges "
+              << "of a crashed worker" << std::endl;
+    std::cerr << "                         are given to its replacement. Text "
+              << "output only." << std::endl;
+    std::cerr << " [--pin | -P]          - Bind each --coordinator worker to its "
+              << "own slice of the" << std::endl;
+    std::cerr << "                         CPUs." << std::endl;
+    std::cerr << " [--worker-timeout | -W] - Seconds a --coordinator worker may "
+              << "take over one range" << std::endl;
+    std::cerr << "                         before it is replaced. 0 waits forever. "
+              << "Default is 600." << std::endl;
+    std::cerr << " [--share-found | -F]  - Share the orders found with every "
+              << "process given the" << std::endl;
+    std::cerr << "                         same file and orders, so they skip "
+              << "each other's finds" << std::endl;
+    std::cerr << "                         and stop together." << std::endl;
+    std::cerr << " [--pipeline | -Q]     - Split the search into filter threads, "
+              << "which drop" << std::endl;
+    std::cerr << "                         redundant algorithms, and evaluator "
+              << "threads, which find" << std::endl;
+    std::cerr << "                         orders. --pipeline=F:E sets the thread "
+              << "counts. Without" << std::endl;
+    std::cerr << "                         them every thread filters and "
+              << "evaluates as the queue needs." << std::endl;
+    std::cerr << " [--ordered | -O]      - Write results in algorithm number "
+              << "order, instead of" << std::endl;
+    std::cerr << "                         interleaved by thread." << std::endl;
+    std::cerr << " [--progress | -G]     - Report the rate and an ETA on stderr "
+              << "every optarg" << std::endl;
+    std::cerr << "                         seconds, " << DEFAULT_PROGRESS_INTERVAL
+              << " by default. SIGUSR1 reports at once." << std::endl;
+    std::cerr << " [--metrics | -M]      - Also rewrite this file with the same "
+              << "snapshot in the" << std::endl;
+    std::cerr << "                         Prometheus text format." << std::endl;
+    std::cerr << " [--trace | -E]        - Write the work of each thread to this file as "
+              << "a Chrome" << std::endl;
+    std::cerr << "                         trace, for chrome://tracing or Perfetto." << std::endl;
     std::cerr << " [--keep-dupes | -k]   - Keep algorithms that contain duplication."
               << std::endl;
     std::cerr << " [--skip-nth | -s]     - Skip nth algorithm." << std::endl;
@@ -325,13 +879,19 @@ void usage(char* progName) {
 }
 
 void doAlgBench(bool lite) {
-    /* operator<() is already defined in Algorithm for different purposes. */
-    std::map<std::string, RedundancyEvaluator> algEvals;
-    algEvals.insert(std::pair<std::string, RedundancyEvaluator>("all redundancies",  &Algorithm::isRedundant));
-    algEvals.insert(std::pair<std::string, RedundancyEvaluator>("inversions",        &Algorithm::hasInversion));
-    algEvals.insert(std::pair<std::string, RedundancyEvaluator>("hidden inversions", &Algorithm::hasHiddenInversion));
-    algEvals.insert(std::pair<std::string, RedundancyEvaluator>("triples",           &Algorithm::hasTriple));
-    algEvals.insert(std::pair<std::string, RedundancyEvaluator>("hidden triples",    &Algorithm::hasHiddenTriple));
+    /**
+     * operator<() is already defined in Algorithm for different purposes. Each
+     * evaluator gets its own instantiation of doAlgReduce, so the redundancy
+     * check is inlined into the reduction rather than called through a member
+     * function pointer.
+     */
+    typedef void (*AlgReducer)(unsigned long long int, ThreadPool*);
+    std::map<std::string, AlgReducer> algEvals;
+    algEvals.insert(std::pair<std::string, AlgReducer>("all redundancies",  &doAlgReduce<&Algorithm::isRedundant>));
+    algEvals.insert(std::pair<std::string, AlgReducer>("inversions",        &doAlgReduce<&Algorithm::hasInversion>));
+    algEvals.insert(std::pair<std::string, AlgReducer>("hidden inversions", &doAlgReduce<&Algorithm::hasHiddenInversion>));
+    algEvals.insert(std::pair<std::string, AlgReducer>("triples",           &doAlgReduce<&Algorithm::hasTriple>));
+    algEvals.insert(std::pair<std::string, AlgReducer>("hidden triples",    &doAlgReduce<&Algorithm::hasHiddenTriple>));
 
     /**
      * @brief The last test simulates the number of algorithms required to find
@@ -350,6 +910,9 @@ void doAlgBench(bool lite) {
         algs.push_back(DEFAULT_ALG_MAX);
     }
 
+    /* One pool for every reduction, so thread startup is not measured. */
+    ThreadPool pool(numThreads);
+
     std::cout << "Performing algorithm reduce benchmarks..." << std::endl;
     auto start = std::chrono::steady_clock::now();
     for (auto evaluator : algEvals) {
@@ -361,16 +924,17 @@ void doAlgBench(bool lite) {
                   << std::setw(COLUMN_WIDTH) << std::left << "Rate ms/Alg"
                   << std::endl;
         for (auto numAlgs : algs)
-            doAlgReduce(numAlgs, evaluator.second);
+            evaluator.second(numAlgs, &pool);
     }
     auto end = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration<double, std::milli>(end - start).count();
     std::cout << std::endl << "Benchmark completed in " << elapsed / 1000 << " seconds." << std::endl;
 }
 
-void doAlgReduce(unsigned long long int algs, bool (Algorithm::*algEval)()) {
+template<RedundancyEvaluator RE>
+void doAlgReduce(unsigned long long int algs, ThreadPool* pool) {
     auto start = std::chrono::steady_clock::now();
-    Algorithms a(numThreads, algs, algEval);
+    StaticAlgorithms<RE> a(numThreads, algs, StaticEvaluator<RE>(), pool);
     AlgorithmList* al = a.getReduction();
     auto end = std::chrono::steady_clock::now();
     auto elapsed = std::chrono::duration<double, std::milli>(end - start).count();
@@ -382,64 +946,326 @@ void doAlgReduce(unsigned long long int algs, bool (Algorithm::*algEval)()) {
          << std::endl;
 }
 
+/**
+ * Prints a binary result file in the text format. The thread number is not
+ * stored, so TN: is omitted.
+ */
+int dumpResults(const char* path) {
+    try {
+        ResultFileReader reader(path);
+        Algorithm start(reader.getStartAlgorithm().c_str());
+        if (start.getLayerDepth() > reader.getLayerDepth())
+            throw std::runtime_error(std::string(path) + " has a start algorithm deeper than its layer depth.");
+        start.setLayerDepth(reader.getLayerDepth());
+        Algorithm algorithm(start);
+        unsigned long long int position = 0;
+        reader.forEach([&](unsigned long long int algNum, unsigned int order, unsigned int) {
+            if (algNum < position) {
+                algorithm = start;
+                position = 0;
+            }
+            algorithm += algNum - position;
+            position = algNum;
+
+            std::cout << "AN:" << std::setw(10) << std::left << algNum;
+            std::cout << "OR:" << std::setw(5)  << std::left << order;
+            std::cout << "AG:";
+            for (const Turn &t : algorithm.getAlgorithm())
+                std::cout << Algorithm::turnToStr(t) << ' ';
+            std::cout << '\n';
+        });
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::cout.flush();
+    return 0;
+}
+
+/**
+ * One row per order that was seen, with a column per algorithm length when
+ * histogramByLength is set.
+ */
+void printHistogram(const OrderHistogram& h) {
+    h.print(std::cout, histogramByLength);
+}
+
+/**
+ * Adds the per-thread histograms into one and frees them. The tables are
+ * small, so adding them on this thread beats starting a reduction.
+ */
+OrderHistogram takeHistogram() {
+    OrderHistogram total(ORDER_MAX);
+    for (OrderHistogram* h : histograms) {
+        total.merge(*h);
+        delete h;
+    }
+    histograms.clear();
+    return total;
+}
+
+int lookupOrder(const char* algorithm) {
+    if (orderDatabase == nullptr || !Algorithm::isValid(algorithm)) {
+        std::cerr << "--lookup needs a valid algorithm and --db." << std::endl;
+        return 1;
+    }
+
+    Algorithm a(algorithm);
+    unsigned int order = orderDatabase->lookup(a);
+    if (order == 0) {
+        std::cerr << a.getAlgorithmStr() << " is redundant or longer than "
+                  << orderDatabase->getMaxLength() << " turns." << std::endl;
+        return 1;
+    }
+    std::cout << "AN:" << std::setw(10) << std::left << a.getAlgorithmNumber();
+    std::cout << "OR:" << std::setw(5)  << std::left << order;
+    std::cout << "AG:" << a.getAlgorithmStr() << std::endl;
+    return 0;
+}
+
+/**
+ * Set up a ThreadCounters per thread and the monitor that samples them. The
+ * monitor always runs, so that SIGUSR1 gets a snapshot without --progress.
+ */
+Monitor* startMonitor(const unsigned long long int resumed, const char* metricsPath) {
+    counters = new ThreadCounters[numThreads];
+    std::vector<ThreadCounters*> sampled;
+    for (unsigned int i = 0; i < numThreads; i++)
+        sampled.push_back(&counters[i]);
+    return new Monitor(sampled, shardEnd - shardStart, resumed, progressInterval,
+                       metricsPath != nullptr ? metricsPath : "");
+}
+
+/* Threads count locally and publish once per chunk or batch. */
+void countWork(const unsigned int threadNum, const uint64_t enumerated, const uint64_t redundant, const uint64_t evaluated, const uint64_t turns) {
+    ThreadCounters& counted = counters[threadNum];
+    ThreadCounters::add(counted.enumerated, enumerated);
+    ThreadCounters::add(counted.redundant, redundant);
+    ThreadCounters::add(counted.evaluated, evaluated);
+    ThreadCounters::add(counted.turns, turns);
+}
+
+/**
+ * Threads take chunks of consecutive algorithms from the scheduler. Within a
+ * chunk the algorithm is simply incremented, and a new chunk is reached by
+ * adding the distance from the end of the last one.
+ */
 void calculateOrder(const unsigned int threadNum) {
     Algorithm algorithm(initialAlgorithm);
     std::vector<Turn> turnSet;
     Cube c(CubieColor::RED, 3);
     unsigned int order;
-    unsigned long long int algorithmCount = threadNum;
-
-    algorithm += threadNum;
-    while (algorithmCount < algorithmCountMax) {
-        if (algorithmCount % skip_nth != 0)
-            goto bypass;
-        if (keepDuplicates || !algorithm.isRedundant()) {
-            order = 0;
+    unsigned long long int position = 0;
+    RangeScheduler::Range range;
+    OrderHistogram chunkHistogram(ORDER_MAX);
+    unsigned long long int initialNumber = initialAlgorithm.getAlgorithmNumber();
+    unsigned long long int bound;
+    uint64_t redundant, evaluated, turns;
+
+    PROFILE_BIND(threadNum);
+    TraceRecorder::nameThread("search " + std::to_string(threadNum));
+    while (scheduler->next(threadNum, range)) {
+        if (orderedOutput && !waitForChunk(threadNum, range))
+            return;
+        if (completedChunks->isMarked(range.chunk)) {
+            if (orderedOutput)
+                writer->pushChunk(threadNum, range.chunk);
+            continue;
+        }
+        TraceRecorder::Span span("chunk", "search", "chunk", range.chunk);
+        if (range.start < position) {
+            algorithm = initialAlgorithm;
+            position = 0;
+        }
+        algorithm += range.start - position;
+        bound = FoundOrders::NO_ALGORITHM;
+        redundant = evaluated = turns = 0;
+
+        for (unsigned long long int algorithmCount = range.start; algorithmCount < range.end;
+             ++algorithmCount, PROFILE_TIMED(ENUMERATE, ++algorithm)) {
+            /* The rest of this thread's chunks come later still, so it can stop. */
+            if (skipFoundOrders && foundOrders->done()) {
+                if (bound == FoundOrders::NO_ALGORITHM)
+                    bound = foundOrders->getBound();
+                if (initialNumber + algorithmCount > bound) {
+                    /* Ordered output must not wait on a chunk nobody will finish. */
+                    if (orderedOutput)
+                        writer->pushChunk(threadNum, range.chunk);
+                    countWork(threadNum, algorithmCount - range.start, redundant, evaluated, turns);
+                    return;
+                }
+            }
+            PROFILE_WALK(algorithmCount);
+            if (heartbeat > 0 && algorithmCount > 0 && algorithmCount % heartbeat == 0)
+                writer->pushHeartbeat(threadNum, algorithmCount);
+
+            if (algorithmCount % skip_nth != 0)
+                continue;
+            if (!keepDuplicates && PROFILE_TIMED(FILTER, algorithm.isRedundant())) {
+                ++redundant;
+                continue;
+            }
+
             turnSet = algorithm.getAlgorithm();
-            do {
-                ++order;
-                c.performAlgorithm(turnSet);
-            } while (!c.isSolved());
-
-            printResult(threadNum, algorithmCount, turnSet, order);
-            if (skipFoundOrders && !numSkipFoundOrders)
-                return;
+            order = orderDatabase != nullptr ? orderDatabase->lookup(algorithm) : 0;
+            if (order == 0) {
+                order = computeOrder(turnSet, c);
+                turns += order*turnSet.size();
+            }
+            ++evaluated;
+
+            if (histogram)
+                chunkHistogram.add(order, turnSet.size());
+            else
+                printResult(threadNum, threadNum, algorithmCount, turnSet, order);
         }
-        
-        bypass:
-        algorithmCount += numThreads;
-        algorithm += numThreads;
-
-        if (heartbeat > 0 && algorithmCount % heartbeat == 0) {
-            coutMutex.lock();
-            std::cout << "HB:" << algorithmCount << std::endl;
-            coutMutex.unlock();
+        position = range.end;
+        countWork(threadNum, range.end - range.start, redundant, evaluated, turns);
+        completeChunk(threadNum, range.chunk, &chunkHistogram);
+        if (skipFoundOrders && !histogram)
+            reportFound(threadNum, initialNumber + scheduler->getStart(completedChunks->getWatermark()), false);
+    }
+}
+
+/**
+ * With --ordered, the writer holds chunks until the ones before them are
+ * done. A thread does not start a chunk more than ORDERED_CHUNKS_PER_THREAD
+ * chunks per thread past the next one to be written, which bounds what the
+ * writer holds to about that many chunks of results per thread.
+ *
+ * The lowest unwritten chunk is always running or next in some thread's
+ * deque, so the wait ends. Returns false if a find search has passed the
+ * chunk, in which case the thread stops.
+ */
+bool waitForChunk(const unsigned int threadNum, const RangeScheduler::Range& range) {
+    unsigned long long int window = ORDERED_CHUNKS_PER_THREAD*numThreads;
+    unsigned long long int initialNumber = initialAlgorithm.getAlgorithmNumber();
+    while (range.chunk >= writer->getNextChunk() + window) {
+        if (skipFoundOrders && foundOrders->done() &&
+            initialNumber + range.start > foundOrders->getBound()) {
+            writer->pushChunk(threadNum, range.chunk);
+            return false;
         }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
+    return true;
 }
 
-void printResult(const unsigned int threadNum, const unsigned long long int algNum, const std::vector<Turn> &alg, const unsigned int order) {
-    coutMutex.lock();
+/**
+ * A chunk counts as complete for checkpoints once its results are written,
+ * which the writer reports to recordFlushed. Histogram counts are kept per
+ * chunk and published together with the chunk.
+ */
+void completeChunk(const unsigned int threadNum, const unsigned long long int chunk, OrderHistogram* chunkHistogram) {
+    /* Found orders wait in foundOrders, not the writer, until they are settled. */
+    if (!histogram && skipFoundOrders) {
+        completedChunks->mark(chunk);
+        if (orderedOutput)
+            writer->pushChunk(threadNum, chunk);
+        return;
+    } else if (!histogram) {
+        writer->pushChunk(threadNum, chunk);
+        return;
+    }
 
-    if (skipFoundOrders) {
-        if (foundOrders[order]) {
-            coutMutex.unlock();
-            return;
+    std::lock_guard<std::mutex> lock(histogramLocks[threadNum]);
+    histograms[threadNum]->merge(*chunkHistogram);
+    completedChunks->mark(chunk);
+    chunkHistogram->clear();
+}
+
+/**
+ * The order database is consulted first. Otherwise the algorithm is repeated
+ * on c, which must start solved and is left solved.
+ */
+unsigned int getOrder(const Algorithm& algorithm, const std::vector<Turn>& turnSet, Cube& c) {
+    unsigned int order = 0;
+    if (orderDatabase != nullptr)
+        order = orderDatabase->lookup(algorithm);
+    return order != 0 ? order : computeOrder(turnSet, c);
+}
+
+unsigned int computeOrder(const std::vector<Turn>& turnSet, Cube& c) {
+    unsigned int order = 0;
+    do {
+        ++order;
+        PROFILE_TIMED(SIMULATE, c.performAlgorithm(turnSet));
+    } while (!PROFILE_TIMED(SOLVED_CHECK, c.isSolved()));
+    return order;
+}
+
+/**
+ * Mark reported and return, lowest first, the found orders whose lowest
+ * algorithm is below limit. Everything below limit must have been searched.
+ * Orders that another process sharing the found orders has a lower algorithm
+ * for are marked but left out; that process reports them.
+ */
+std::vector<std::pair<unsigned long long int, unsigned int>> takeSettled(const unsigned long long int limit) {
+    std::vector<std::pair<unsigned long long int, unsigned int>> settled;
+    for (unsigned int order = 0; order < ORDER_MAX; order++) {
+        unsigned long long int algNumber = foundOrders->getOwnBest(order);
+        if (algNumber < limit && foundOrders->isWanted(order) && !foundOrders->isReported(order))
+            settled.emplace_back(algNumber, order);
+    }
+    std::sort(settled.begin(), settled.end());
+
+    std::vector<std::pair<unsigned long long int, unsigned int>> lowest;
+    for (const std::pair<unsigned long long int, unsigned int>& found : settled)
+        if (foundOrders->report(found.second) && found.first <= foundOrders->getBest(found.second))
+            lowest.push_back(found);
+    return lowest;
+}
+
+/**
+ * Write the settled found orders through the writer's last producer, or in a
+ * --coordinator worker add them to rangeFound. The lock keeps that producer
+ * to one thread at a time, and keeps the orders in algorithm order. Workers
+ * pass wait = false to skip a report already running.
+ */
+void reportFound(const unsigned int threadNum, const unsigned long long int limit, const bool wait) {
+    std::unique_lock<std::mutex> lock(reportMutex, std::defer_lock);
+    if (wait)
+        lock.lock();
+    else if (!lock.try_lock())
+        return;
+
+    TraceRecorder::Span span("report", "found");
+    unsigned long long int initialNumber = initialAlgorithm.getAlgorithmNumber();
+    for (const std::pair<unsigned long long int, unsigned int>& found : takeSettled(limit)) {
+        if (rangeFound != nullptr) {
+            rangeFound->push_back({found.first, found.second, threadNum});
+            continue;
         }
-        foundOrders[order] = true;
-        --numSkipFoundOrders;
+        Algorithm algorithm(initialAlgorithm);
+        algorithm += found.first - initialNumber;
+        writer->pushResult(numThreads, threadNum, found.first - initialNumber,
+                           algorithm.getAlgorithm(), found.second);
+    }
+}
+
+/**
+ * Results are handed to the writer thread, and found orders are claimed
+ * atomically, so no lock is taken here. Only one thread may use a producer.
+ *
+ * For range searches a found order is only claimed here. It is written by
+ * reportFound once nothing below it is left to search, so each order gets
+ * its lowest algorithm however the work was split between threads.
+ */
+void printResult(const size_t producer, const unsigned int threadNum, const unsigned long long int algNum, const std::vector<Turn> &alg, const unsigned int order) {
+    if (skipFoundOrders && reportLowest) {
+        /* A relaxed load filters out everything above the current minimum. */
+        unsigned long long int algNumber = initialAlgorithm.getAlgorithmNumber() + algNum;
+        if (foundOrders->isWanted(order) && !foundOrders->isReported(order) &&
+            algNumber < foundOrders->getBest(order))
+            foundOrders->claim(order, algNumber);
+        return;
+    } else if (skipFoundOrders) {
+        if (foundOrders->isFound(order) ||
+            !foundOrders->claim(order, initialAlgorithm.getAlgorithmNumber() + algNum))
+            return;
     } else if (showFoundOrder && order != foundOrder) {
-        coutMutex.unlock();
         return;
     }
 
-    std::cout << "TN:" << std::setw(5)  << std::left << threadNum;
-    std::cout << "AN:" << std::setw(10) << std::left << algNum;
-    std::cout << "OR:" << std::setw(5)  << std::left << order;
-    std::cout << "AG:";
-    for (const Turn &t : alg)
-        std::cout << Algorithm::layerToChar(t.layer)
-                  << (t.clockwise ? " ": "' ");
-    std::cout << std::endl;
-    coutMutex.unlock();
+    writer->pushResult(producer, threadNum, algNum, alg, order);
 }
@@ -0,0 +1,108 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    The state and functions that the modes of the cli share. cli.cpp reads
+ *    the options into these globals and runs the range search. The
+ *    --input, --coordinator, --pipeline and --checkpoint modes are in
+ *    input.cpp, coordinator.cpp, pipeline.cpp and checkpoint.cpp.
+ */
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "AlgorithmInput.hpp"
+#include "Checkpoint.hpp"
+#include "CubeOrders.hpp"
+#include "FoundOrders.hpp"
+#include "Monitor.hpp"
+#include "OrderDatabase.hpp"
+#include "OrderHistogram.hpp"
+#include "RangeScheduler.hpp"
+#include "ResultWriter.hpp"
+#include "../Cube.hpp"
+#include "../Algorithm.hpp"
+
+#ifndef CLI_H
+#define CLI_H
+
+/* The lowest algorithm of an order found in a --coordinator worker's range. */
+struct FoundRecord {
+    unsigned long long int algNumber; // Absolute.
+    unsigned int order;
+    unsigned int threadNum;
+};
+
+extern unsigned long long int skip_nth;
+extern unsigned long long int algorithmCountMax;
+extern unsigned long long int heartbeat;
+extern unsigned long long int chunkSize;
+extern unsigned long long int flushMs;
+extern unsigned long long int shardIndex;
+extern unsigned long long int shardCount;
+extern unsigned long long int shardStart;
+extern unsigned long long int shardEnd;
+extern unsigned long long int workerTimeout;
+extern bool pipeline;
+extern unsigned int pipelineFilters;
+extern unsigned int numThreads;
+extern bool keepDuplicates;
+extern bool skipFoundOrders;
+extern bool histogram;
+extern Algorithm initialAlgorithm;
+extern FoundOrders* foundOrders;
+extern RangeScheduler* scheduler;
+extern ResultWriter* writer;
+extern ResultWriter::Format outputFormat;
+extern std::vector<OrderHistogram*> histograms;
+extern OrderDatabase* orderDatabase;
+extern AlgorithmInput::Format inputFormat;
+extern ChunkSet* completedChunks;
+extern std::mutex* histogramLocks;
+extern std::mutex progressMutex;
+extern std::vector<bool> writtenOrders;
+extern ThreadCounters* counters;
+extern std::vector<FoundRecord>* rangeFound; // Set in a --coordinator worker, which sends these instead of writing them.
+
+void printHistogram(const OrderHistogram& h);
+OrderHistogram takeHistogram();
+void countWork(const unsigned int threadNum, const uint64_t enumerated, const uint64_t redundant, const uint64_t evaluated, const uint64_t turns);
+void calculateOrder(const unsigned int threadNum);
+unsigned int getOrder(const Algorithm& algorithm, const std::vector<Turn>& turnSet, Cube& c);
+unsigned int computeOrder(const std::vector<Turn>& turnSet, Cube& c);
+std::vector<std::pair<unsigned long long int, unsigned int>> takeSettled(const unsigned long long int limit);
+void reportFound(const unsigned int threadNum, const unsigned long long int limit, const bool wait);
+void printResult(const size_t producer, const unsigned int threadNum, const unsigned long long int algNum, const std::vector<Turn> &alg, const unsigned int order);
+int evaluateInput(const char* path);
+int restoreCheckpoint(const char* path);
+Checkpoint takeCheckpoint();
+void recordFlushed(const std::vector<unsigned long long int>& chunks, const std::vector<unsigned int>& orders);
+int coordinate(const unsigned int numWorkers, const bool pin);
+void runPipeline();
+
+#endif // CLI_H
@@ -0,0 +1,353 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    --coordinator: a range search split between forked worker processes,
+ *    which are sent ranges of algorithm numbers and send back their output.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "ProcessFarm.hpp"
+#include "cli.hpp"
+
+const unsigned long long int DISPATCH_CHUNKS = 64;
+const unsigned int MAX_RANGE_ATTEMPTS = 3;
+
+/* Sent by the coordinator to a worker process. An id of 0 asks it to exit. */
+struct RangeAssignment {
+    unsigned long long int id;
+    unsigned long long int start;
+    unsigned long long int end;
+    uint64_t found[(ORDER_MAX + 63) / 64]; // Orders not to look for, one bit each.
+};
+
+/* Sent back once the range is done, followed by its output, histogram and found orders. */
+struct RangeCompletion {
+    unsigned long long int id;
+    unsigned long long int outputSize;
+    unsigned long long int histogramSize;
+    unsigned long long int numFound;
+};
+
+std::vector<FoundRecord>* rangeFound;
+
+bool assignRange(const int fd, const unsigned long long int id, const unsigned long long int start, const unsigned long long int end);
+bool collectRange(const int fd, const unsigned long long int id, OrderHistogram* total, std::vector<std::string>* candidates);
+void writeCandidates(const std::vector<std::string>& candidates, const unsigned long long int limit);
+int serveRanges(const int fd, const size_t workerNum);
+void searchRange(const unsigned long long int start, const unsigned long long int end, const int fd);
+
+/**
+ * Hand ranges of DISPATCH_CHUNKS chunks to worker processes, lowest first,
+ * and write each range's output once the whole range is done. A worker that
+ * dies, or takes longer than --worker-timeout over a range, loses only that
+ * range, which goes to the next free worker.
+ *
+ * Found orders are held back as candidates until every range below them is
+ * done, so each order is written with its lowest algorithm.
+ */
+int coordinate(const unsigned int numWorkers, const bool pin) {
+    struct Dispatch {
+        unsigned long long int id;
+        unsigned long long int start;
+        unsigned long long int end;
+        unsigned int attempts;
+    };
+
+    ProcessFarm farm(numWorkers, serveRanges, pin);
+    std::deque<Dispatch> retry;
+    std::vector<Dispatch> assigned(farm.size());
+    std::vector<bool> busy(farm.size(), false);
+    std::vector<std::chrono::steady_clock::time_point> deadlines(farm.size());
+    std::chrono::seconds timeout(workerTimeout);
+    OrderHistogram total(ORDER_MAX);
+    unsigned long long int next = shardStart;
+    unsigned long long int nextId = 1;
+    unsigned long long int dispatchSize = chunkSize*DISPATCH_CHUNKS;
+    unsigned long long int initialNumber = initialAlgorithm.getAlgorithmNumber();
+    std::vector<std::string> candidates(ORDER_MAX);
+
+    while (true) {
+        bool searching = !(skipFoundOrders && initialNumber + next > foundOrders->getBound());
+        for (size_t i = 0; i < farm.size(); i++) {
+            if (busy[i])
+                continue;
+            Dispatch d;
+            if (!retry.empty()) {
+                d = retry.front();
+                retry.pop_front();
+            } else if (searching && next < shardEnd) {
+                d = {nextId++, next, std::min(next + dispatchSize, shardEnd), 0};
+                next = d.end;
+            } else {
+                break;
+            }
+
+            if (!assignRange(farm.getFd(i), d.id, d.start, d.end)) {
+                retry.push_front(d);
+                farm.restart(i);
+                continue;
+            }
+            assigned[i] = d;
+            busy[i] = true;
+            deadlines[i] = std::chrono::steady_clock::now() + timeout;
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<size_t> workers;
+        for (size_t i = 0; i < farm.size(); i++) {
+            if (!busy[i])
+                continue;
+            fds.push_back({farm.getFd(i), POLLIN, 0});
+            workers.push_back(i);
+        }
+        if (fds.empty())
+            break;
+
+        /* Wake by the first deadline, so a hung worker cannot stall the others. */
+        int wait = -1;
+        if (workerTimeout > 0) {
+            std::chrono::steady_clock::time_point due = deadlines[workers[0]];
+            for (size_t i : workers)
+                due = std::min(due, deadlines[i]);
+            long long int ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                due - std::chrono::steady_clock::now()).count() + 1;
+            wait = (int)std::min(std::max(ms, 0LL), (long long int)INT_MAX);
+        }
+        if (poll(fds.data(), fds.size(), wait) < 0)
+            continue;
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        for (size_t f = 0; f < fds.size(); f++) {
+            size_t i = workers[f];
+            bool expired = fds[f].revents == 0 && workerTimeout > 0 && now >= deadlines[i];
+            if (fds[f].revents == 0 && !expired)
+                continue;
+            busy[i] = false;
+            if (!expired && collectRange(farm.getFd(i), assigned[i].id, histogram ? &total : nullptr, &candidates))
+                continue;
+
+            Dispatch d = assigned[i];
+            std::cerr << "Worker " << i << (expired ? " timed out" : " died") << " searching algorithms "
+                      << d.start << " to " << d.end << ", reassigning them." << std::endl;
+            if (++d.attempts >= MAX_RANGE_ATTEMPTS) {
+                std::cerr << "Giving up after " << d.attempts << " attempts." << std::endl;
+                for (size_t j = 0; j < farm.size(); j++)
+                    farm.stop(j);
+                return 1;
+            }
+            retry.push_front(d);
+            farm.restart(i);
+        }
+
+        unsigned long long int unsearched = next;
+        for (const Dispatch& d : retry)
+            unsearched = std::min(unsearched, d.start);
+        for (size_t i = 0; i < farm.size(); i++)
+            if (busy[i])
+                unsearched = std::min(unsearched, assigned[i].start);
+        if (skipFoundOrders)
+            writeCandidates(candidates, initialNumber + unsearched);
+    }
+
+    if (skipFoundOrders)
+        writeCandidates(candidates, FoundOrders::NO_ALGORITHM);
+    for (size_t i = 0; i < farm.size(); i++)
+        assignRange(farm.getFd(i), 0, 0, 0);
+    if (histogram)
+        printHistogram(total);
+    return 0;
+}
+
+bool assignRange(const int fd, const unsigned long long int id, const unsigned long long int start, const unsigned long long int end) {
+    RangeAssignment assignment;
+    assignment.id = id;
+    assignment.start = start;
+    assignment.end = end;
+    for (uint64_t& word : assignment.found)
+        word = 0;
+    /* Nothing in the range can beat an order's lowest algorithm below it. */
+    unsigned long long int first = initialAlgorithm.getAlgorithmNumber() + start;
+    for (unsigned int order = 0; skipFoundOrders && order < ORDER_MAX; order++)
+        if (!foundOrders->isWanted(order) || foundOrders->isReported(order) ||
+            foundOrders->getBest(order) < first)
+            assignment.found[order / 64] |= 1ULL << (order % 64);
+    return ProcessFarm::writeAll(fd, &assignment, sizeof(assignment));
+}
+
+/**
+ * Read a worker's finished range and write its output. The range's found
+ * orders are claimed, and kept in candidates as text lines if they are the
+ * lowest so far, rather than written.
+ */
+bool collectRange(const int fd, const unsigned long long int id, OrderHistogram* total, std::vector<std::string>* candidates) {
+    RangeCompletion completion;
+    if (!ProcessFarm::readAll(fd, &completion, sizeof(completion)) || completion.id != id ||
+        completion.numFound > ORDER_MAX)
+        return false;
+    std::string output(completion.outputSize, '\0');
+    std::string counts(completion.histogramSize, '\0');
+    std::vector<FoundRecord> found(completion.numFound);
+    if (!ProcessFarm::readAll(fd, &output[0], output.size()) ||
+        !ProcessFarm::readAll(fd, &counts[0], counts.size()) ||
+        !ProcessFarm::readAll(fd, found.data(), found.size()*sizeof(FoundRecord)))
+        return false;
+
+    unsigned long long int initialNumber = initialAlgorithm.getAlgorithmNumber();
+    for (const FoundRecord& f : found) {
+        if (f.order >= ORDER_MAX || foundOrders->isReported(f.order))
+            continue;
+        foundOrders->claim(f.order, f.algNumber);
+        if (foundOrders->getOwnBest(f.order) != f.algNumber)
+            continue;
+
+        Algorithm algorithm(initialAlgorithm);
+        algorithm += f.algNumber - initialNumber;
+        std::ostringstream line;
+        line << "TN:" << std::setw(5)  << std::left << f.threadNum;
+        line << "AN:" << std::setw(10) << std::left << f.algNumber - initialNumber;
+        line << "OR:" << std::setw(5)  << std::left << f.order << "AG:";
+        for (const Turn& t : algorithm.getAlgorithm())
+            line << Algorithm::turnToStr(t) << " ";
+        (*candidates)[f.order] = line.str();
+    }
+    std::cout.write(output.data(), (std::streamsize)output.size());
+    std::cout.flush();
+
+    if (total != nullptr) {
+        std::istringstream in(counts);
+        bool byLength;
+        total->read(in, byLength);
+    }
+    return true;
+}
+
+/**
+ * Write the candidates whose algorithm is below limit, everything below
+ * which has been searched.
+ */
+void writeCandidates(const std::vector<std::string>& candidates, const unsigned long long int limit) {
+    for (const std::pair<unsigned long long int, unsigned int>& found : takeSettled(limit))
+        std::cout << candidates[found.second] << "\n";
+    std::cout.flush();
+}
+
+/**
+ * The body of a --coordinator worker process. Searches each range it is sent
+ * with --threads threads, collecting the output in a temporary file.
+ */
+int serveRanges(const int fd, const size_t) {
+    FILE* output = std::tmpfile();
+    if (output == nullptr)
+        return 1;
+
+    /* Each range gets its own found orders, so it reports its own lowest algorithms. */
+    FoundOrders* wanted = foundOrders;
+    RangeAssignment assignment;
+    while (ProcessFarm::readAll(fd, &assignment, sizeof(assignment)) && assignment.id != 0) {
+        if (skipFoundOrders) {
+            foundOrders = new FoundOrders(ORDER_MAX, true);
+            for (unsigned int order = 0; order < ORDER_MAX; order++)
+                if (wanted->isWanted(order) && !(assignment.found[order / 64] & (1ULL << (order % 64))))
+                    foundOrders->markWanted(order);
+        }
+        std::vector<FoundRecord> found;
+        rangeFound = skipFoundOrders ? &found : nullptr;
+        searchRange(assignment.start, assignment.end, fileno(output));
+        rangeFound = nullptr;
+        if (skipFoundOrders) {
+            delete foundOrders;
+            foundOrders = wanted;
+        }
+
+        std::string text;
+        char buffer[65536];
+        std::rewind(output);
+        for (size_t n; (n = std::fread(buffer, 1, sizeof(buffer), output)) > 0;)
+            text.append(buffer, n);
+        std::rewind(output);
+        if (ftruncate(fileno(output), 0) != 0)
+            return 1;
+
+        std::ostringstream counts;
+        if (histogram) {
+            takeHistogram().print(counts, true);
+        }
+
+        RangeCompletion completion;
+        completion.id = assignment.id;
+        completion.outputSize = text.size();
+        completion.histogramSize = counts.str().size();
+        completion.numFound = found.size();
+        if (!ProcessFarm::writeAll(fd, &completion, sizeof(completion)) ||
+            !ProcessFarm::writeAll(fd, text.data(), text.size()) ||
+            !ProcessFarm::writeAll(fd, counts.str().data(), counts.str().size()) ||
+            !ProcessFarm::writeAll(fd, found.data(), found.size()*sizeof(FoundRecord)))
+            return 1;
+    }
+    std::fclose(output);
+    return 0;
+}
+
+/**
+ * Search [start, end) with numThreads threads, writing results to fd. The
+ * per-thread histograms are left in histograms.
+ */
+void searchRange(const unsigned long long int start, const unsigned long long int end, const int fd) {
+    std::vector<std::thread> threads(numThreads);
+    scheduler = new RangeScheduler(numThreads, start, end, chunkSize);
+    completedChunks = new ChunkSet(scheduler->getNumChunks());
+    histogramLocks = new std::mutex[numThreads];
+    for (unsigned int i=0; histogram && i<numThreads; i++)
+        histograms.push_back(new OrderHistogram(ORDER_MAX));
+
+    writer = new ResultWriter(numThreads + 1, fd, flushMs, ResultWriter::TEXT, initialAlgorithm);
+    /* Counted, but worker processes are not monitored. */
+    counters = new ThreadCounters[numThreads];
+    for (unsigned int i=0; i<numThreads; i++)
+        threads.at(i) = std::thread(calculateOrder, i);
+    for (std::thread &t : threads)
+        t.join();
+    delete[] counters;
+    if (skipFoundOrders)
+        reportFound(0, FoundOrders::NO_ALGORITHM, true);
+    delete writer;
+    delete scheduler;
+    delete completedChunks;
+    delete[] histogramLocks;
+}
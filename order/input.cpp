@@ -0,0 +1,158 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    --input: the orders of algorithms read from a file or stdin, reported
+ *    in input order.
+ */
+
+#include <atomic>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "AlgorithmInput.hpp"
+#include "BlockingQueue.hpp"
+#include "ReorderBuffer.hpp"
+#include "cli.hpp"
+
+void evaluateBatches(const unsigned int threadNum, BlockingQueue<InputBatch*>* work, ReorderBuffer<InputBatch*>* done);
+bool emitBatch(const InputBatch& batch);
+
+/**
+ * This thread reads batches, the workers evaluate them, and an emitter thread
+ * prints them in input order. Batches come from a fixed pool that the emitter
+ * refills, which bounds how far reading can run ahead of output.
+ */
+int evaluateInput(const char* path) {
+    int fd = STDIN_FILENO;
+    if (std::string(path) != "-" && (fd = open(path, O_RDONLY)) < 0) {
+        std::cerr << "Cannot open " << path << "." << std::endl;
+        return 1;
+    }
+
+    AlgorithmInput input(fd, inputFormat);
+    BlockingQueue<InputBatch*> freeBatches;
+    BlockingQueue<InputBatch*> work;
+    ReorderBuffer<InputBatch*> done;
+    std::vector<InputBatch> batches(numThreads*4);
+    for (InputBatch& batch : batches)
+        freeBatches.push(&batch);
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 0; i < numThreads; i++)
+        workers.emplace_back(evaluateBatches, i, &work, &done);
+    std::atomic<bool> failed(false);
+    std::thread emitter([&] {
+        InputBatch* batch;
+        while (done.next(batch)) {
+            if (!failed && !emitBatch(*batch))
+                failed = true;
+            freeBatches.push(batch);
+        }
+    });
+
+    unsigned long long int sequence = 0;
+    InputBatch* batch;
+    while (!failed && !(skipFoundOrders && foundOrders->done()) && freeBatches.pop(batch)) {
+        if (!input.read(*batch, chunkSize))
+            break;
+        batch->sequence = sequence++;
+        work.push(batch);
+    }
+    work.close();
+    done.finish(sequence);
+
+    for (std::thread& t : workers)
+        t.join();
+    emitter.join();
+    if (fd != STDIN_FILENO)
+        close(fd);
+    return failed ? 1 : 0;
+}
+
+void evaluateBatches(const unsigned int threadNum, BlockingQueue<InputBatch*>* work, ReorderBuffer<InputBatch*>* done) {
+    Cube c(CubieColor::RED, 3);
+    InputBatch* batch;
+
+    while (work->pop(batch)) {
+        batch->worker = threadNum;
+        batch->algorithms.resize(batch->count);
+        batch->orders.assign(batch->count, 0);
+
+        const char* line = batch->text.c_str();
+        for (size_t i = 0; i < batch->count; i++) {
+            Algorithm& algorithm = batch->algorithms[i];
+            if (inputFormat == AlgorithmInput::BINARY) {
+                algorithm.setAlgorithmNumber(batch->numbers[i]);
+            } else {
+                bool valid = Algorithm::isValid(line);
+                if (valid)
+                    algorithm.setAlgorithm(line);
+                line += std::strlen(line) + 1;
+                if (!valid)
+                    continue;
+            }
+            if (skipFoundOrders && foundOrders->done())
+                continue;
+            batch->orders[i] = getOrder(algorithm, algorithm.getAlgorithm(), c);
+        }
+        done->put(batch->sequence, batch);
+    }
+}
+
+/**
+ * Runs on the emitter thread, which is the only producer for the writer.
+ *
+ * @return false If an algorithm cannot be written in the output format.
+ */
+bool emitBatch(const InputBatch& batch) {
+    for (size_t i = 0; i < batch.count; i++) {
+        unsigned int order = batch.orders[i];
+        if (order == 0) {
+            if (!(skipFoundOrders && foundOrders->done()))
+                std::cerr << "Skipping input algorithm " << batch.firstItem + i + 1
+                          << ", which is not valid." << std::endl;
+            continue;
+        }
+
+        const Algorithm& algorithm = batch.algorithms[i];
+        if (!histogram && !writer->canNumber(algorithm)) {
+            std::cerr << "Input algorithm " << batch.firstItem + i + 1 << " turns inner slices or "
+                      << "wide layers, which binary output cannot number." << std::endl;
+            return false;
+        }
+        std::vector<Turn> turnSet = algorithm.getAlgorithm();
+        if (histogram)
+            histograms[0]->add(order, turnSet.size());
+        else
+            printResult(0, batch.worker, algorithm.getAlgorithmNumber(), turnSet, order);
+    }
+    return true;
+}
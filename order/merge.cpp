@@ -0,0 +1,477 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    Combines the outputs of several cli runs, such as the slices of a
+ *    --shard search or a run and its --resume, into the output of one run
+ *    with one thread.
+ *
+ *    Result outputs, text or binary, are merged by algorithm number. Each
+ *    input is streamed if it is already in algorithm number order, as the
+ *    output of a one thread run is. Any other input is read into memory and
+ *    sorted first. A result that appears twice, as results written after the
+ *    last checkpoint do on resume, is kept once. --first-found keeps only the
+ *    first algorithm of each order, which is what --find-orders prints.
+ *
+ *    Histogram outputs are added together.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "CubeOrders.hpp"
+#include "OrderHistogram.hpp"
+#include "ResultFile.hpp"
+#include "../Algorithm.hpp"
+
+struct MergeRecord {
+    unsigned long long int algNum = 0;
+    bool heartbeat = false; // An HB: line, which sorts before the result with the same number.
+    unsigned int order = 0;
+    unsigned int length = 0;
+    std::string line; // The text line, for text inputs.
+
+    bool operator<(const MergeRecord& other) const {
+        if (algNum != other.algNum)
+            return algNum < other.algNum;
+        return heartbeat && !other.heartbeat;
+    }
+
+    bool sameKey(const MergeRecord& other) const {
+        return algNum == other.algNum && heartbeat == other.heartbeat;
+    }
+};
+
+class MergeInput {
+    public:
+        virtual ~MergeInput() {}
+
+        /**
+         * @return false Once the input is exhausted.
+         */
+        virtual bool next(MergeRecord& record) = 0;
+};
+
+class TextInput : public MergeInput {
+    public:
+        TextInput(const std::string& path) : in(path), finished(false) {
+            if (!in)
+                throw std::runtime_error("Cannot open " + path + ".");
+        }
+
+        virtual bool next(MergeRecord& record) {
+            std::string line;
+            while (std::getline(in, line)) {
+                if (parse(line, record))
+                    return true;
+                if (line == "HB:-1")
+                    finished = true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief True if the input ended with the HB:-1 heartbeat.
+         */
+        bool isFinished() const {
+            return finished;
+        }
+
+    private:
+        std::ifstream in;
+        bool finished;
+
+        static bool parse(const std::string& line, MergeRecord& record) {
+            record.line = line;
+            if (line.compare(0, 3, "HB:") == 0 && line.size() > 3 && line[3] != '-') {
+                record.heartbeat = true;
+                record.algNum = std::strtoull(line.c_str() + 3, nullptr, 10);
+                record.order = 0;
+                record.length = 0;
+                return true;
+            }
+
+            size_t an = line.find("AN:");
+            size_t order = line.find("OR:");
+            size_t alg = line.find("AG:");
+            if (an == std::string::npos || order == std::string::npos || alg == std::string::npos)
+                return false;
+            record.heartbeat = false;
+            record.algNum = std::strtoull(line.c_str() + an + 3, nullptr, 10);
+            record.order = (unsigned int)std::strtoul(line.c_str() + order + 3, nullptr, 10);
+            /* Turns such as 2R' or 3Fw take several characters, so count words. */
+            record.length = 0;
+            std::istringstream turns(line.substr(alg + 3));
+            std::string turn;
+            while (turns >> turn)
+                ++record.length;
+            return true;
+        }
+};
+
+class BinaryInput : public MergeInput {
+    public:
+        BinaryInput(const std::string& path) : reader(path), index(0) {}
+
+        virtual bool next(MergeRecord& record) {
+            while (index == block.size()) {
+                if (!reader.next(block))
+                    return false;
+                index = 0;
+            }
+            record.algNum = block.algNums[index];
+            record.order = block.orders[index];
+            record.length = block.lengths[index];
+            ++index;
+            return true;
+        }
+
+        const std::string& getStartAlgorithm() const {
+            return reader.getStartAlgorithm();
+        }
+
+        unsigned int getLayerDepth() const {
+            return reader.getLayerDepth();
+        }
+
+    private:
+        ResultFileReader reader;
+        ResultFileReader::Block block;
+        size_t index;
+};
+
+/* An input that was not in order, read whole and sorted. */
+class SortedInput : public MergeInput {
+    public:
+        SortedInput(MergeInput& source) : index(0) {
+            MergeRecord record;
+            while (source.next(record))
+                records.push_back(record);
+            std::stable_sort(records.begin(), records.end());
+        }
+
+        virtual bool next(MergeRecord& record) {
+            if (index == records.size())
+                return false;
+            record = records[index++];
+            return true;
+        }
+
+    private:
+        std::vector<MergeRecord> records;
+        size_t index;
+};
+
+enum InputKind {
+    TEXT_RESULTS,
+    BINARY_RESULTS,
+    HISTOGRAM
+};
+
+static struct option longopts[] = {
+    {"first-found",   no_argument,       nullptr, 'f'},
+    {"output-format", required_argument, nullptr, 'r'},
+    {"algstart",      required_argument, nullptr, 'a'},
+    {"help",          no_argument,       nullptr, 'h'},
+    { NULL,           0,                 NULL,     0 }
+};
+
+bool firstFound;
+bool binaryOutput;
+std::string startAlgorithm;
+
+void usage(char* progName);
+bool getInputKind(const std::string& path, InputKind& kind);
+MergeInput* openInput(const std::string& path, InputKind kind);
+int mergeHistograms(const std::vector<std::string>& paths);
+int mergeResults(const std::vector<std::string>& paths, InputKind kind);
+bool fitsLayerDepth(const MergeRecord& record, unsigned int layerDepth);
+
+int main(int argc, char *argv[]) {
+    int ch;
+    firstFound = false;
+    binaryOutput = false;
+    startAlgorithm = "";
+
+    opterr = 0;
+    while ((ch = getopt_long(argc, argv, "fr:a:h", longopts, NULL)) != -1) {
+        switch (ch) {
+            case 'f':
+                firstFound = true;
+                break;
+            case 'r':
+                if (std::string(optarg) == "binary") {
+                    binaryOutput = true;
+                } else if (std::string(optarg) != "text") {
+                    usage(argv[0]);
+                    return 0;
+                }
+                break;
+            case 'a':
+                startAlgorithm = optarg;
+                break;
+            case 'h':
+            default:
+                usage(argv[0]);
+                return 0;
+        }
+    }
+
+    std::vector<std::string> paths(argv + optind, argv + argc);
+    if (paths.empty()) {
+        usage(argv[0]);
+        return 0;
+    }
+
+    InputKind kind = TEXT_RESULTS;
+    for (size_t i = 0; i < paths.size(); i++) {
+        InputKind k;
+        if (!getInputKind(paths[i], k)) {
+            std::cerr << "Cannot read " << paths[i] << "." << std::endl;
+            return 1;
+        }
+        if (i > 0 && k != kind) {
+            std::cerr << paths[i] << " is not the same kind of output as "
+                      << paths[0] << "." << std::endl;
+            return 1;
+        }
+        kind = k;
+    }
+
+    try {
+        if (kind == HISTOGRAM)
+            return mergeHistograms(paths);
+        return mergeResults(paths, kind);
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
+
+void usage(char* progName) {
+    std::cerr << "usage: " << progName << " "
+              << "[--first-found | -f] "
+              << "[--output-format | -r] "
+              << "[--algstart | -a] "
+              << "[--help | -h] "
+              << "FILE..." << std::endl;
+    std::cerr << std::endl;
+    std::cerr << " Merges cli outputs, text or binary results or histograms, "
+              << "into one output." << std::endl;
+    std::cerr << std::endl;
+    std::cerr << " [--first-found | -f]   - Keep only the first algorithm of each "
+              << "order, for" << std::endl;
+    std::cerr << "                          --find-orders searches." << std::endl;
+    std::cerr << " [--output-format | -r] - \"text\" (default) or \"binary\"."
+              << std::endl;
+    std::cerr << " [--algstart | -a]      - The --algstart of the runs, recorded in "
+              << "binary output" << std::endl;
+    std::cerr << "                          made from text inputs. Default is \"F\"."
+              << std::endl;
+    std::cerr << " [--help | -h]          - Display this message." << std::endl;
+    std::cerr << std::endl;
+}
+
+bool getInputKind(const std::string& path, InputKind& kind) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[ResultFileFormat::MAGIC_SIZE];
+    if (!in.read(magic, sizeof(magic))) {
+        /* Shorter than the magic, so an empty or nearly empty text output. */
+        kind = TEXT_RESULTS;
+        return in.eof();
+    }
+    if (std::memcmp(magic, ResultFileFormat::getMagic(), sizeof(magic)) == 0)
+        kind = BINARY_RESULTS;
+    else if (std::strncmp(magic, "Order ", 6) == 0)
+        kind = HISTOGRAM;
+    else
+        kind = TEXT_RESULTS;
+    return true;
+}
+
+MergeInput* openInput(const std::string& path, InputKind kind) {
+    if (kind == BINARY_RESULTS)
+        return new BinaryInput(path);
+    return new TextInput(path);
+}
+
+int mergeHistograms(const std::vector<std::string>& paths) {
+    OrderHistogram total(ORDER_MAX);
+    bool byLength = false;
+    for (const std::string& path : paths) {
+        std::ifstream in(path);
+        if (!total.read(in, byLength)) {
+            std::cerr << path << " is not a histogram." << std::endl;
+            return 1;
+        }
+    }
+    total.print(std::cout, byLength);
+    return 0;
+}
+
+int mergeResults(const std::vector<std::string>& paths, InputKind kind) {
+    /* Binary inputs fix the start algorithm and layer depth, and must agree on them. */
+    unsigned int layerDepth = 1;
+    if (kind == BINARY_RESULTS) {
+        for (const std::string& path : paths) {
+            BinaryInput input(path);
+            if (path != paths[0] && (input.getStartAlgorithm() != startAlgorithm ||
+                                     input.getLayerDepth() != layerDepth)) {
+                std::cerr << path << " starts at \"" << input.getStartAlgorithm() << "\" at layer depth "
+                          << input.getLayerDepth() << ", not \"" << startAlgorithm
+                          << "\" at layer depth " << layerDepth << "." << std::endl;
+                return 1;
+            }
+            startAlgorithm = input.getStartAlgorithm();
+            layerDepth = input.getLayerDepth();
+        }
+    }
+    if (startAlgorithm.empty())
+        startAlgorithm = Algorithm().getAlgorithmStr();
+    Algorithm start(startAlgorithm.c_str());
+    if (start.getLayerDepth() > layerDepth && kind == BINARY_RESULTS) {
+        std::cerr << paths[0] << " has a start algorithm deeper than its layer depth." << std::endl;
+        return 1;
+    }
+    layerDepth = std::max(layerDepth, start.getLayerDepth());
+    start.setLayerDepth(layerDepth);
+
+    /* Stream the inputs that are in order, and sort the rest. */
+    std::vector<std::unique_ptr<MergeInput>> inputs;
+    bool finished = false;
+    for (const std::string& path : paths) {
+        std::unique_ptr<MergeInput> input(openInput(path, kind));
+        MergeRecord record, previous;
+        bool sorted = true;
+        for (bool first = true; input->next(record); first = false) {
+            sorted = sorted && (first || !(record < previous));
+            previous = record;
+        }
+        TextInput* text = dynamic_cast<TextInput*>(input.get());
+        finished = finished || (text != nullptr && text->isFinished());
+
+        input.reset(openInput(path, kind));
+        if (!sorted)
+            input.reset(new SortedInput(*input));
+        inputs.push_back(std::move(input));
+    }
+
+    typedef std::pair<MergeRecord, size_t> Head;
+    auto later = [](const Head& a, const Head& b) { return b.first < a.first; };
+    std::priority_queue<Head, std::vector<Head>, decltype(later)> heads(later);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        Head head;
+        head.second = i;
+        if (inputs[i]->next(head.first))
+            heads.push(head);
+    }
+
+    std::string buffer;
+    std::unique_ptr<ResultFileWriter> file;
+    if (binaryOutput)
+        file.reset(new ResultFileWriter(buffer, startAlgorithm, layerDepth));
+    Algorithm algorithm(start);
+    unsigned long long int position = 0;
+    std::vector<bool> seenOrders(ORDER_MAX, false);
+    MergeRecord last;
+    bool haveLast = false;
+    char field[64];
+
+    while (!heads.empty()) {
+        Head head = heads.top();
+        heads.pop();
+        MergeRecord record = head.first;
+        if (inputs[head.second]->next(head.first))
+            heads.push(head);
+
+        if (haveLast && record.sameKey(last))
+            continue;
+        last = record;
+        haveLast = true;
+
+        if (record.heartbeat) {
+            if (!binaryOutput)
+                buffer += record.line + "\n";
+            continue;
+        }
+        if (firstFound && record.order < seenOrders.size()) {
+            if (seenOrders[record.order])
+                continue;
+            seenOrders[record.order] = true;
+        }
+
+        if (file) {
+            /* Text from a deeper search, or from --input, is numbered in another alphabet. */
+            if (kind == TEXT_RESULTS && !fitsLayerDepth(record, layerDepth)) {
+                std::cerr << "AN:" << record.algNum << " turns deeper layers than \"" << startAlgorithm
+                          << "\", so binary output cannot number it." << std::endl;
+                return 1;
+            }
+            file->add(record.algNum, record.order, record.length);
+        } else if (kind == TEXT_RESULTS) {
+            buffer += record.line + "\n";
+        } else {
+            algorithm += record.algNum - position;
+            position = record.algNum;
+            int n = std::snprintf(field, sizeof(field), "AN:%-10lluOR:%-5uAG:", record.algNum, record.order);
+            buffer.append(field, (size_t)n);
+            for (const Turn& t : algorithm.getAlgorithm()) {
+                buffer += Algorithm::turnToStr(t);
+                buffer += ' ';
+            }
+            buffer += '\n';
+        }
+
+        if (buffer.size() >= (1 << 20)) {
+            std::cout.write(buffer.data(), (std::streamsize)buffer.size());
+            buffer.clear();
+        }
+    }
+
+    if (file)
+        file->flushBlock();
+    std::cout.write(buffer.data(), (std::streamsize)buffer.size());
+
+    if (finished && !binaryOutput)
+        std::cout << "HB:-1" << std::endl;
+    std::cout.flush();
+    return 0;
+}
+
+/* Whether a text record's turns can be numbered at layerDepth. */
+bool fitsLayerDepth(const MergeRecord& record, unsigned int layerDepth) {
+    const char* turns = record.line.c_str() + record.line.find("AG:") + 3;
+    return !Algorithm::isValid(turns) || Algorithm(turns).getLayerDepth() <= layerDepth;
+}
@@ -0,0 +1,238 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    --pipeline: the range search split into filter threads, which drop
+ *    redundant algorithms, and evaluator threads, which find the orders.
+ */
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "MpmcQueue.hpp"
+#include "TraceRecorder.hpp"
+#include "cli.hpp"
+
+const size_t PIPELINE_BATCHES_PER_THREAD = 4;
+
+/* Algorithms that passed the redundancy filter, on their way to evaluation. */
+struct AlgorithmBatch {
+    static const size_t CAPACITY = 256;
+    size_t count = 0;
+    unsigned long long int algNums[CAPACITY]; // Counted from --algstart, like AN:.
+    unsigned long long int numbers[CAPACITY]; // Absolute, for the order database.
+    std::vector<Turn> turns[CAPACITY];
+    std::vector<unsigned long long int> heartbeats;
+};
+
+enum PipelineRole {
+    FILTER,
+    EVALUATE,
+    ANY // Filter, but evaluate whenever full batches back up.
+};
+
+MpmcQueue<AlgorithmBatch*>* freeBatches;
+MpmcQueue<AlgorithmBatch*>* fullBatches;
+std::atomic<unsigned int> activeFilters;
+
+void runPipelineStage(const unsigned int threadNum, const PipelineRole role);
+AlgorithmBatch* acquireBatch(const unsigned int threadNum, const PipelineRole role, Cube& c);
+void evaluateBatch(const unsigned int threadNum, AlgorithmBatch* batch, Cube& c);
+
+/**
+ * The range search as a pipeline. The RangeScheduler hands out chunks of
+ * algorithm numbers, filter threads walk them and batch up the algorithms
+ * that are not redundant, and evaluator threads find the orders. Batches come
+ * from a fixed pool, so a fast stage can only get PIPELINE_BATCHES_PER_THREAD
+ * batches per thread ahead of a slow one.
+ */
+void runPipeline() {
+    std::vector<PipelineRole> roles(numThreads, ANY);
+    for (unsigned int i = 0; pipelineFilters > 0 && i < numThreads; i++)
+        roles[i] = i < pipelineFilters ? FILTER : EVALUATE;
+
+    size_t numBatches = numThreads*PIPELINE_BATCHES_PER_THREAD;
+    std::vector<AlgorithmBatch> batches(numBatches);
+    freeBatches = new MpmcQueue<AlgorithmBatch*>(numBatches);
+    fullBatches = new MpmcQueue<AlgorithmBatch*>(numBatches);
+    for (AlgorithmBatch& batch : batches)
+        freeBatches->tryPush(&batch);
+    activeFilters = 0;
+    for (PipelineRole role : roles)
+        if (role != EVALUATE)
+            ++activeFilters;
+
+    scheduler = new RangeScheduler(numThreads, shardStart, shardEnd, chunkSize);
+    writer = new ResultWriter(numThreads + 1, STDOUT_FILENO, flushMs, outputFormat,
+                              initialAlgorithm);
+    for (unsigned int i=0; histogram && i<numThreads; i++)
+        histograms.push_back(new OrderHistogram(ORDER_MAX));
+
+    std::vector<std::thread> threads;
+    for (unsigned int i=0; i<numThreads; i++)
+        threads.emplace_back(runPipelineStage, i, roles[i]);
+    for (std::thread &t : threads)
+        t.join();
+    /* Batches finish out of order, so found orders are only settled at the end. */
+    if (skipFoundOrders)
+        reportFound(0, FoundOrders::NO_ALGORITHM, true);
+    delete writer;
+    delete scheduler;
+    delete freeBatches;
+    delete fullBatches;
+
+    if (histogram) {
+        printHistogram(takeHistogram());
+    }
+}
+
+void runPipelineStage(const unsigned int threadNum, const PipelineRole role) {
+    Algorithm algorithm(initialAlgorithm);
+    Cube c(CubieColor::RED, 3);
+    unsigned long long int position = 0;
+    RangeScheduler::Range range;
+    AlgorithmBatch* batch = nullptr;
+    AlgorithmBatch* full;
+    bool filtering = role != EVALUATE;
+    bool passedBound = false;
+    unsigned long long int initialNumber = initialAlgorithm.getAlgorithmNumber();
+    unsigned long long int bound = FoundOrders::NO_ALGORITHM;
+    bool useNumbers = orderDatabase != nullptr && initialAlgorithm.getLayerDepth() == 1;
+
+    TraceRecorder::nameThread("pipeline " + std::to_string(threadNum));
+    while (true) {
+        bool evaluate = role == EVALUATE ||
+                        (role == ANY && (!filtering || fullBatches->sizeApprox() >= numThreads));
+        if (evaluate && fullBatches->tryPop(full)) {
+            evaluateBatch(threadNum, full, c);
+            freeBatches->tryPush(full);
+            continue;
+        }
+
+        /* Past every wanted order's lowest algorithm, filters stop early and evaluators drain. */
+        if (filtering && (passedBound || !scheduler->next(threadNum, range))) {
+            if (batch != nullptr && (batch->count > 0 || !batch->heartbeats.empty()))
+                fullBatches->tryPush(batch);
+            else if (batch != nullptr)
+                freeBatches->tryPush(batch);
+            batch = nullptr;
+            filtering = false;
+            activeFilters.fetch_sub(1, std::memory_order_release);
+            continue;
+        } else if (filtering) {
+            TraceRecorder::Span span("filter", "pipeline", "chunk", range.chunk);
+            if (range.start < position) {
+                algorithm = initialAlgorithm;
+                position = 0;
+            }
+            algorithm += range.start - position;
+            bound = FoundOrders::NO_ALGORITHM;
+            uint64_t walked = 0, redundant = 0;
+
+            for (unsigned long long int algorithmCount = range.start; algorithmCount < range.end; ++algorithmCount, ++algorithm) {
+                if (skipFoundOrders && foundOrders->done()) {
+                    if (bound == FoundOrders::NO_ALGORITHM)
+                        bound = foundOrders->getBound();
+                    passedBound = initialNumber + algorithmCount > bound;
+                    if (passedBound)
+                        break;
+                }
+                ++walked;
+                if (batch == nullptr)
+                    batch = acquireBatch(threadNum, role, c);
+                if (heartbeat > 0 && algorithmCount > 0 && algorithmCount % heartbeat == 0)
+                    batch->heartbeats.push_back(algorithmCount);
+                if (algorithmCount % skip_nth != 0)
+                    continue;
+                if (!keepDuplicates && algorithm.isRedundant()) {
+                    ++redundant;
+                    continue;
+                }
+
+                size_t i = batch->count++;
+                batch->algNums[i] = algorithmCount;
+                batch->numbers[i] = useNumbers ? algorithm.getAlgorithmNumber() : ~0ULL;
+                batch->turns[i] = algorithm.getAlgorithm();
+                if (batch->count == AlgorithmBatch::CAPACITY) {
+                    fullBatches->tryPush(batch);
+                    batch = nullptr;
+                }
+            }
+            position = range.end;
+            countWork(threadNum, walked, redundant, 0, 0);
+            continue;
+        }
+
+        /* Filters push their last batch before leaving, so this sees every batch. */
+        if (role == FILTER || (activeFilters.load(std::memory_order_acquire) == 0 &&
+                               fullBatches->sizeApprox() == 0))
+            break;
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * Take an empty batch from the pool. While the pool is empty, a thread that
+ * may evaluate works off full batches instead of waiting.
+ */
+AlgorithmBatch* acquireBatch(const unsigned int threadNum, const PipelineRole role, Cube& c) {
+    AlgorithmBatch* batch;
+    while (!freeBatches->tryPop(batch)) {
+        if (role == ANY && fullBatches->tryPop(batch)) {
+            evaluateBatch(threadNum, batch, c);
+            return batch;
+        }
+        std::this_thread::yield();
+    }
+    return batch;
+}
+
+/* Leaves the batch empty. */
+void evaluateBatch(const unsigned int threadNum, AlgorithmBatch* batch, Cube& c) {
+    TraceRecorder::Span span("evaluate", "pipeline", "algorithms", batch->count);
+    uint64_t turns = 0;
+    for (unsigned long long int algNum : batch->heartbeats)
+        writer->pushHeartbeat(threadNum, algNum);
+    for (size_t i = 0; i < batch->count; i++) {
+        unsigned int order = 0;
+        if (orderDatabase != nullptr)
+            order = orderDatabase->lookup(batch->numbers[i]);
+        if (order == 0) {
+            order = computeOrder(batch->turns[i], c);
+            turns += order*batch->turns[i].size();
+        }
+
+        if (histogram)
+            histograms[threadNum]->add(order, batch->turns[i].size());
+        else
+            printResult(threadNum, threadNum, batch->algNums[i], batch->turns[i], order);
+    }
+    countWork(threadNum, 0, 0, batch->count, turns);
+    batch->count = 0;
+    batch->heartbeats.clear();
+}
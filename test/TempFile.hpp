@@ -0,0 +1,70 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+/**
+ * Description:
+ *    A uniquely named file under /tmp for tests that need a real path or
+ *    file descriptor. The file is created holding the given contents and is
+ *    removed when the TempFile goes out of scope.
+ */
+
+#include <cassert>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+#ifndef TEMPFILE_H
+#define TEMPFILE_H
+
+class TempFile {
+    public:
+        TempFile(const std::string& contents = "") {
+            char name[] = "/tmp/rubiks_testXXXXXX";
+            int fd = mkstemp(name);
+            assert(fd >= 0);
+            for (size_t written = 0; written < contents.size(); ) {
+                ssize_t n = write(fd, contents.data() + written, contents.size() - written);
+                assert(n > 0);
+                written += (size_t)n;
+            }
+            close(fd);
+            path = name;
+        }
+
+        TempFile(const TempFile&) = delete;
+        TempFile& operator=(const TempFile&) = delete;
+
+        ~TempFile() {
+            unlink(path.c_str());
+        }
+
+        const std::string& getPath() const {
+            return path;
+        }
+
+    private:
+        std::string path;
+};
+
+#endif // TEMPFILE_H
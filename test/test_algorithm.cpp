@@ -39,6 +39,7 @@ void test_hidden_inversions();
 void test_triples();
 void test_hidden_triples();
 void test_string();
+void test_layer_depth();
 
 void verify_turns(std::vector<Turn> results, std::vector<Turn> expected);
 
@@ -54,6 +55,7 @@ int main() {
     test_triples();
     test_hidden_triples();
     test_string();
+    test_layer_depth();
 
     return 0;
 }
@@ -248,6 +250,24 @@ void test_setAlgorithm() {
     verify_turns(alg_1.getAlgorithm(), algorithm);
     verify_turns(alg_2.getAlgorithm(), alg_1.getAlgorithm());
 
+    /* However it was set, the number matches counting up from F. */
+    Algorithm alg_3;
+    alg_3 += 12 + 144 + 1728 + 5000;
+    Algorithm alg_4(alg_3.getAlgorithmStr().c_str());
+    assert(alg_4.getAlgorithmNumber() == alg_3.getAlgorithmNumber());
+    assert(Algorithm("F").getAlgorithmNumber() == 0);
+    assert(Algorithm("B'").getAlgorithmNumber() == 11);
+    assert(Algorithm("F F").getAlgorithmNumber() == 12);
+    alg_4 += 1;
+    alg_3 += 1;
+    verify_turns(alg_4.getAlgorithm(), alg_3.getAlgorithm());
+
+    /* An empty algorithm is numbered 0 at any layer depth. */
+    alg_4.setAlgorithm(std::vector<Turn>{});
+    assert(alg_4.getAlgorithmNumber() == 0);
+    alg_4.setLayerDepth(2);
+    assert(alg_4.getAlgorithmNumber() == 0);
+
     std::cout << "Passed" << std::endl;
 }
 
@@ -578,6 +598,8 @@ void verify_turns(std::vector<Turn> results, std::vector<Turn> expected) {
     for (unsigned int i = 0; i < expected.size(); i++) {
         assert(expected.at(i).layer     == results.at(i).layer);
         assert(expected.at(i).clockwise == results.at(i).clockwise);
+        assert(expected.at(i).depth     == results.at(i).depth);
+        assert(expected.at(i).wide      == results.at(i).wide);
     }
 }
 
@@ -595,3 +617,80 @@ void test_string() {
 
     std::cout << "Passed" << std::endl;
 }
+
+void test_layer_depth() {
+    std::cout << "Testing layer depth... ";
+
+    Algorithm alg_1;
+    assert(alg_1.getLayerDepth() == 1);
+    assert(alg_1.getAlgorithmBase() == 12);
+    assert(Algorithm::getAlgorithmBase(2) == 36);
+    assert(Algorithm::getAlgorithmBase(3) == 60);
+
+    std::cout << " t1 ";
+    std::string str_1 = "2R Rw' F 3Bw 3U' D";
+    alg_1.setAlgorithm(str_1.c_str());
+    assert(alg_1.getLayerDepth() == 3);
+    assert(alg_1.getAlgorithmStr().compare(str_1) == 0);
+    verify_turns(alg_1.getAlgorithm(),
+                 {{Layer::R, true, 1}, {Layer::R, false, 1, true},
+                  {Layer::F, true}, {Layer::B, true, 2, true},
+                  {Layer::U, false, 2}, {Layer::D, true}});
+
+    std::cout << " t2 ";
+    assert(Algorithm::isValid("2R Rw' 3Fw 12L"));
+    assert(!Algorithm::isValid("0R"));
+    assert(!Algorithm::isValid("2M"));
+    assert(!Algorithm::isValid("Mw"));
+    assert(!Algorithm::isValid("Rww"));
+    assert(!Algorithm::isValid("R 2"));
+    assert(!Algorithm::isValid(""));
+    assert(!Algorithm::isValid(" "));
+
+    /* The odometer counts through every turn in the extended alphabet. */
+    std::cout << " t3 ";
+    Algorithm alg_2;
+    alg_2.setLayerDepth(2);
+    std::vector<Turn> results;
+    for (int i = 0; i < 36; i++) {
+        for (Turn t : alg_2.getAlgorithm())
+            results.push_back(t);
+        ++alg_2;
+    }
+    assert(results.size() == 36);
+    verify_turns({results.at(0), results.at(11), results.at(12),
+                  results.at(23), results.at(24), results.at(35)},
+                 {{Layer::F, true}, {Layer::B, false}, {Layer::F, true, 1},
+                  {Layer::B, false, 1}, {Layer::F, true, 1, true},
+                  {Layer::B, false, 1, true}});
+    verify_turns(alg_2.getAlgorithm(), {{Layer::F, true}, {Layer::F, true}});
+
+    /* Changing the depth keeps the turns of the algorithm. */
+    std::cout << " t4 ";
+    Algorithm alg_3("Rw U 2F");
+    alg_3.setLayerDepth(4);
+    assert(alg_3.getAlgorithmBase() == 84);
+    assert(alg_3.getAlgorithmStr().compare("Rw U 2F") == 0);
+    alg_3.setLayerDepth(2);
+    assert(alg_3.getAlgorithmStr().compare("Rw U 2F") == 0);
+
+    /* Parallel layers on the same axis commute. */
+    std::cout << " t5 ";
+    assert(Algorithm("R 2R R'").hasHiddenInversion());
+    assert(Algorithm("R Lw R'").hasHiddenInversion());
+    assert(!Algorithm("R 2U R'").hasHiddenInversion());
+    assert(Algorithm("R R 2R R").hasHiddenTriple());
+    assert(!Algorithm("R R 2F R").hasHiddenTriple());
+    assert(Algorithm("2R 2R'").hasInversion());
+    assert(!Algorithm("2R R'").hasInversion());
+
+    /* Parsing into a reused algorithm starts from the plain alphabet again. */
+    std::cout << " t6 ";
+    Algorithm alg_4("2R U");
+    assert(alg_4.getLayerDepth() == 2);
+    alg_4.setAlgorithm("R U");
+    assert(alg_4.getLayerDepth() == 1);
+    assert(alg_4.getAlgorithmNumber() == Algorithm("R U").getAlgorithmNumber());
+
+    std::cout << "Passed" << std::endl;
+}
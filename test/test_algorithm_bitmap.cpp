@@ -0,0 +1,251 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cassert>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../order/AlgorithmBitmap.hpp"
+
+void test_containers();
+void test_append();
+void test_order();
+void test_serialize();
+
+void verify_members(const AlgorithmBitmap& bitmap, const std::vector<unsigned long long int>& expected);
+bool throws_on_deserialize(const std::string& serialized);
+
+int main() {
+    test_containers();
+    test_append();
+    test_order();
+    test_serialize();
+
+    return 0;
+}
+
+void test_containers() {
+    std::cout << "Testing containers... ";
+
+    /* 4096 members still fit the array container; the next one converts it. */
+    std::cout << " t1 ";
+    AlgorithmBitmap bitmap;
+    std::vector<unsigned long long int> expected;
+    for (unsigned long long int i = 0; i < 4096; i++) {
+        bitmap.add(i*3);
+        expected.push_back(i*3);
+    }
+    verify_members(bitmap, expected);
+    unsigned long long int arrayUsage = bitmap.getMemoryUsage();
+
+    bitmap.add(4096*3);
+    expected.push_back(4096*3);
+    verify_members(bitmap, expected);
+    unsigned long long int bitmapUsage = bitmap.getMemoryUsage();
+    assert(bitmapUsage <= arrayUsage);
+    assert(!bitmap.contains(1));
+    assert(!bitmap.contains(4096*3 + 1));
+    assert(!bitmap.contains(65535));
+
+    /* A bitmap container has a fixed size, however many members it holds. */
+    for (unsigned long long int i = 4096*3 + 2; i < 65536; i += 2) {
+        bitmap.add(i);
+        expected.push_back(i);
+    }
+    verify_members(bitmap, expected);
+    assert(bitmap.getMemoryUsage() == bitmapUsage);
+
+    /* Members in later blocks, sparse and dense, around the block edges. */
+    std::cout << " t2 ";
+    for (unsigned long long int i = 65536 - 1; i < 65536 + 5000; i++) {
+        if (i <= expected.back())
+            continue;
+        bitmap.add(i);
+        expected.push_back(i);
+    }
+    bitmap.add(5ULL << 16);
+    expected.push_back(5ULL << 16);
+    bitmap.add((6ULL << 16) - 1);
+    expected.push_back((6ULL << 16) - 1);
+    verify_members(bitmap, expected);
+    assert(!bitmap.contains(65536 + 5000));
+    assert(!bitmap.contains(3ULL << 16));
+
+    std::cout << "Passed" << std::endl;
+}
+
+void test_append() {
+    std::cout << "Testing append... ";
+
+    std::cout << " t1 ";
+    AlgorithmBitmap left;
+    AlgorithmBitmap right;
+    std::vector<unsigned long long int> expected;
+    for (unsigned long long int i = 0; i < 5000; i++) {
+        left.add(i*2);
+        expected.push_back(i*2);
+    }
+    for (unsigned long long int i = 0; i < 100; i++) {
+        right.add(70000 + i*7);
+        expected.push_back(70000 + i*7);
+    }
+    AlgorithmBitmap both;
+    both.append(left);
+    both.append(right);
+    verify_members(both, expected);
+
+    /* The sets share segments, so adding to one must leave the others alone. */
+    std::cout << " t2 ";
+    left.add(60000);
+    right.add(80000);
+    assert(left.contains(60000) && !both.contains(60000));
+    assert(right.contains(80000) && !both.contains(80000));
+    both.add(90000);
+    assert(both.contains(90000) && !right.contains(90000));
+    expected.push_back(90000);
+    verify_members(both, expected);
+    assert(left.size() == 5001);
+    assert(right.size() == 101);
+
+    std::cout << " t3 ";
+    AlgorithmBitmap overlap;
+    overlap.add(70000);
+    bool thrown = false;
+    try {
+        both.append(overlap);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+    both.append(AlgorithmBitmap());
+    verify_members(both, expected);
+
+    /* Many small slices of one block end up in neighbouring segments. */
+    std::cout << " t4 ";
+    AlgorithmBitmap slices;
+    expected.clear();
+    for (unsigned long long int i = 0; i < 40; i++) {
+        AlgorithmBitmap slice;
+        for (unsigned long long int j = 0; j < 3; j++) {
+            slice.add(65536*2 + i*100 + j*11);
+            expected.push_back(65536*2 + i*100 + j*11);
+        }
+        slices.append(slice);
+    }
+    verify_members(slices, expected);
+    assert(!slices.contains(65536*2 + 1));
+    assert(!slices.contains(65536*2 + 3999));
+    assert(!slices.contains(65536));
+    assert(!slices.contains(65536*3));
+
+    std::cout << "Passed" << std::endl;
+}
+
+void test_order() {
+    std::cout << "Testing order... ";
+
+    AlgorithmBitmap bitmap;
+    bitmap.add(10);
+    bool thrown = false;
+    try {
+        bitmap.add(10);
+    } catch (const std::invalid_argument&) {
+        thrown = true;
+    }
+    assert(thrown);
+    verify_members(bitmap, {10});
+
+    std::cout << "Passed" << std::endl;
+}
+
+void test_serialize() {
+    std::cout << "Testing serialize... ";
+
+    AlgorithmBitmap left;
+    AlgorithmBitmap right;
+    std::vector<unsigned long long int> expected;
+    for (unsigned long long int i = 0; i < 6000; i++) {
+        left.add(i);
+        expected.push_back(i);
+    }
+    for (unsigned long long int i = 1; i < 50; i++) {
+        right.add(i << 20);
+        expected.push_back(i << 20);
+    }
+    left.append(right);
+
+    std::cout << " t1 ";
+    std::stringstream stream;
+    left.serialize(stream);
+    verify_members(AlgorithmBitmap::deserialize(stream), expected);
+
+    /* An array container whose offsets are out of order. */
+    std::cout << " t2 ";
+    AlgorithmBitmap array;
+    array.add(1);
+    array.add(2);
+    array.add(3);
+    std::stringstream arrayStream;
+    array.serialize(arrayStream);
+    std::string corrupt = arrayStream.str();
+    std::swap(corrupt[37], corrupt[39]);
+    assert(throws_on_deserialize(corrupt));
+
+    /* A bitmap container with more bits set than its cardinality. */
+    std::cout << " t3 ";
+    AlgorithmBitmap dense;
+    for (unsigned long long int i = 0; i < 5000; i++)
+        dense.add(i);
+    std::stringstream denseStream;
+    dense.serialize(denseStream);
+    corrupt = denseStream.str();
+    corrupt[37 + 100*8] = 1;
+    assert(throws_on_deserialize(corrupt));
+    corrupt[37 + 100*8] = 0;
+    assert(!throws_on_deserialize(corrupt));
+
+    std::cout << "Passed" << std::endl;
+}
+
+void verify_members(const AlgorithmBitmap& bitmap, const std::vector<unsigned long long int>& expected) {
+    assert(bitmap.size() == expected.size());
+    assert(bitmap.empty() == expected.empty());
+    std::vector<unsigned long long int> members(bitmap.begin(), bitmap.end());
+    assert(members == expected);
+    for (unsigned long long int member : expected)
+        assert(bitmap.contains(member));
+}
+
+bool throws_on_deserialize(const std::string& serialized) {
+    std::stringstream stream(serialized);
+    try {
+        AlgorithmBitmap::deserialize(stream);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
@@ -33,6 +33,7 @@ void test_sized_constructors(unsigned int cubeSize);
 void test_operators();
 void test_getCubeSize();
 void test_turns();
+void test_multilayer_turns();
 
 Cube getScrambled();
 std::vector<CubieColor> getExpectedScrambled();
@@ -48,6 +49,7 @@ int main() {
    test_operators();
    test_getCubeSize();
    test_turns();
+   test_multilayer_turns();
 
    return 0;
 }
@@ -164,6 +166,16 @@ void test_operators() {
    verify_cube(c8_mv, getExpected(CubieColor::RED,    8));
    verify_cube(c9_mv, getExpected(CubieColor::YELLOW, 9));
 
+   /* Assignment between cubes of the same size only copies cubies. */
+   Cube c9_tn(CubieColor::YELLOW, 9);
+   c9_tn.turn({Layer::R, true, 3, true});
+   assert(c9_cp != c9_tn);
+   c9_cp = c9_tn;
+   assert(c9_cp == c9_tn);
+   c9_tn.turn({Layer::R, false, 3, true});
+   assert(c9_cp != c9_tn);
+   verify_cube(c9_tn, getExpected(CubieColor::YELLOW, 9));
+
    std::cout << "Passed" << std::endl;
 }
 
@@ -273,6 +285,70 @@ void test_turns() {
    std::cout << "Passed" << std::endl;
 }
 
+void test_multilayer_turns() {
+   std::cout << "Testing multi-layer turns... ";
+
+   /* Turning the far layer of a cube is turning the opposite face. */
+   for (unsigned int size = 2; size < 6; size++) {
+      Cube c1(CubieColor::RED, size), c2(CubieColor::RED, size);
+      c1.turn({Layer::R, true, size - 1});
+      c2.turn({Layer::L, false});
+      assert(c1 == c2);
+      c1.turn({Layer::U, false, size - 1});
+      c2.turn({Layer::D, true});
+      assert(c1 == c2);
+      c1.turn({Layer::F, true, size - 1});
+      c2.turn({Layer::B, false});
+      assert(c1 == c2);
+   }
+
+   /* A wide turn is the same as turning each of its layers. */
+   Cube c1(CubieColor::RED, 5), c2(CubieColor::RED, 5), c3(CubieColor::RED, 5);
+   c1.turn({Layer::F, true, 2, true});
+   c2.turn({Layer::F, true});
+   c2.turn({Layer::F, true, 1});
+   c2.turn({Layer::F, true, 2});
+   assert(c1 == c2);
+   assert(!c1.isSolved());
+
+   c1.turn({Layer::D, false, 1, true});
+   c2.turn({Layer::D, false, 1});
+   c2.turn({Layer::D, false});
+   assert(c1 == c2);
+
+   /* Inner slices return home after four turns. */
+   c3.turn({Layer::B, true, 1}); assert(!c3.isSolved());
+   c3.turn({Layer::B, true, 1}); assert(!c3.isSolved());
+   c3.turn({Layer::B, true, 1}); assert(!c3.isSolved());
+   c3.turn({Layer::B, true, 1}); assert(c3.isSolved());
+   c3.turn({Layer::L, true, 2}); assert(!c3.isSolved());
+   c3.turn({Layer::L, false, 2}); assert(c3.isSolved());
+
+   /* Turning every layer rotates the whole cube, which is still solved. */
+   c3.turn({Layer::R, true, 4, true});
+   assert(c3.isSolved());
+   assert(c3 != Cube(CubieColor::RED, 5));
+
+   /* Turns deeper than the cube are ignored. */
+   Cube c4(CubieColor::RED, 3);
+   c4.turn({Layer::U, true, 3});
+   assert(c4 == Cube(CubieColor::RED, 3));
+
+   /* Algorithms carry the depth of each turn. */
+   Cube c5(CubieColor::RED, 4), c6(CubieColor::RED, 4);
+   Algorithm alg("Rw U' 2F 3Dw' B");
+   c5.performAlgorithm(alg.getAlgorithm());
+   c6.turn({Layer::R, true, 1, true});
+   c6.turn({Layer::U, false});
+   c6.turn({Layer::F, true, 1});
+   c6.turn({Layer::D, false, 2, true});
+   c6.turn({Layer::B, true});
+   assert(c5 == c6);
+   assert(!c5.isSolved());
+
+   std::cout << "Passed" << std::endl;
+}
+
 /**
  * Returns a cube in the following arrangement:
  * 
@@ -0,0 +1,93 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../Algorithm.hpp"
+#include "../Cube.hpp"
+#include "../order/OrderDatabase.hpp"
+#include "TempFile.hpp"
+
+void test_lookup();
+
+int main() {
+    test_lookup();
+
+    return 0;
+}
+
+void test_lookup() {
+    std::cout << "Testing order database... ";
+
+    /* Every algorithm of up to three turns: 97 bitmap words, thirteen
+     * directory entries, and thousands of packed orders, so entries straddle
+     * 64 bit words and superblocks. */
+    const unsigned int maxLength = 3;
+    unsigned long long int numAlgorithms = OrderDatabase::getNumAlgorithms(maxLength);
+    std::vector<unsigned int> expected(numAlgorithms, 0);
+    unsigned long long int numEntries = 0;
+    Algorithm algorithm;
+    Cube c(CubieColor::RED, 3);
+    for (unsigned long long int algNum = 0; algNum < numAlgorithms; algNum++, ++algorithm) {
+        if (algorithm.isRedundant())
+            continue;
+        std::vector<Turn> turns = algorithm.getAlgorithm();
+        do {
+            expected[algNum]++;
+            c.performAlgorithm(turns);
+        } while (!c.isSolved());
+        numEntries++;
+    }
+
+    TempFile file;
+    OrderDatabase::build(file.getPath(), maxLength, 3);
+    OrderDatabase database(file.getPath());
+
+    std::cout << " t1 ";
+    assert(database.getMaxLength() == maxLength);
+    assert(database.getNumAlgorithms() == numAlgorithms);
+    assert(database.getNumEntries() == numEntries);
+    assert(numEntries*OrderDatabase::BITS_PER_ORDER > 64*OrderDatabase::SUPERBLOCK_WORDS);
+
+    std::cout << " t2 ";
+    unsigned long long int rank = 0;
+    for (unsigned long long int algNum = 0; algNum < numAlgorithms; algNum++) {
+        assert(database.lookup(algNum) == expected[algNum]);
+        assert(database.rank(algNum) == rank);
+        if (expected[algNum] != 0)
+            rank++;
+    }
+    assert(database.rank(numAlgorithms) == numEntries);
+    assert(database.lookup(numAlgorithms) == 0);
+
+    std::cout << " t3 ";
+    assert(database.lookup(Algorithm("R U")) == 105);
+    assert(database.lookup(Algorithm("R R'")) == 0);
+    assert(database.lookup(Algorithm("2R U")) == 0);
+    assert(database.lookup(Algorithm("R U R' U'")) == 0);
+
+    std::cout << "Passed" << std::endl;
+}
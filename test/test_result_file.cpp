@@ -0,0 +1,175 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../order/ResultFile.hpp"
+#include "TempFile.hpp"
+
+struct Record {
+    unsigned long long int algNum;
+    unsigned int order;
+    unsigned int length;
+};
+
+void test_round_trip();
+void test_truncated();
+
+std::string encode(const std::vector<Record>& records, unsigned int layerDepth = 1);
+
+int main() {
+    test_round_trip();
+    test_truncated();
+
+    return 0;
+}
+
+void test_round_trip() {
+    std::cout << "Testing binary round trip... ";
+
+    /* Two full blocks and a partial one, with deltas of both signs and sizes. */
+    std::vector<Record> records;
+    unsigned long long int algNum = 1ULL << 40;
+    for (size_t i = 0; i < 2*ResultFileFormat::BLOCK_RECORDS + 100; i++) {
+        if (i % 5 == 0)
+            algNum -= i % 1000;
+        else if (i % 7 == 0)
+            algNum += 1ULL << 35;
+        else
+            algNum += i % 3;
+        records.push_back({algNum, (unsigned int)(i % 1261), (unsigned int)(i % 40)});
+    }
+    records.push_back({0, 1, 0});
+    records.push_back({~0ULL, 1260, 1});
+
+    TempFile file(encode(records, 3));
+    {
+        ResultFileReader reader(file.getPath());
+        assert(reader.getStartAlgorithm() == "R U");
+        assert(reader.getLayerDepth() == 3);
+
+        std::cout << " t1 ";
+        ResultFileReader::Block block;
+        size_t blocks = 0;
+        size_t i = 0;
+        while (reader.next(block)) {
+            assert(block.size() == ResultFileFormat::BLOCK_RECORDS || i + block.size() == records.size());
+            for (size_t j = 0; j < block.size(); j++, i++) {
+                assert(block.algNums[j] == records[i].algNum);
+                assert(block.orders[j] == records[i].order);
+                assert(block.lengths[j] == records[i].length);
+            }
+            blocks++;
+        }
+        assert(blocks == 3);
+        assert(i == records.size());
+        assert(!reader.next(block));
+    }
+    {
+        std::cout << " t2 ";
+        ResultFileReader reader(file.getPath());
+        size_t i = 0;
+        reader.forEach([&](unsigned long long int algNum, unsigned int order, unsigned int length) {
+            assert(algNum == records[i].algNum);
+            assert(order == records[i].order);
+            assert(length == records[i].length);
+            i++;
+        });
+        assert(i == records.size());
+    }
+
+    std::cout << "Passed" << std::endl;
+}
+
+void test_truncated() {
+    std::cout << "Testing truncated files... ";
+
+    std::vector<Record> records;
+    for (unsigned int i = 0; i < 1000; i++)
+        records.push_back({(unsigned long long int)(i*7919 % 1000), i, i % 20});
+    std::string contents = encode(records);
+    size_t header = ResultFileFormat::MAGIC_SIZE + 3*sizeof(uint32_t) + 3;
+
+    /* Cut inside the header: the reader refuses to open the file. */
+    std::cout << " t1 ";
+    for (size_t cut : {(size_t)4, header - 1}) {
+        TempFile file(contents.substr(0, cut));
+        bool thrown = false;
+        try {
+            ResultFileReader reader(file.getPath());
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    /* Cut inside a block: opening works, decoding the block throws. */
+    std::cout << " t2 ";
+    for (size_t cut : {header + 2, header + 12, contents.size() - 1}) {
+        TempFile file(contents.substr(0, cut));
+        ResultFileReader reader(file.getPath());
+        ResultFileReader::Block block;
+        bool thrown = false;
+        try {
+            reader.next(block);
+        } catch (const std::runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+
+    /* Just the header is an empty result file. */
+    std::cout << " t3 ";
+    TempFile file(contents.substr(0, header));
+    ResultFileReader reader(file.getPath());
+    ResultFileReader::Block block;
+    assert(!reader.next(block));
+
+    /* Version 1 files did not record the layer depth, so they are refused. */
+    std::cout << " t4 ";
+    std::string oldVersion = contents;
+    oldVersion[ResultFileFormat::MAGIC_SIZE] = 1;
+    TempFile oldFile(oldVersion);
+    bool thrown = false;
+    try {
+        ResultFileReader oldReader(oldFile.getPath());
+    } catch (const std::runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    std::cout << "Passed" << std::endl;
+}
+
+std::string encode(const std::vector<Record>& records, unsigned int layerDepth) {
+    std::string out;
+    ResultFileWriter writer(out, "R U", layerDepth);
+    for (const Record& r : records)
+        writer.add(r.algNum, r.order, r.length);
+    writer.flushBlock();
+    return out;
+}
@@ -0,0 +1,121 @@
+/**
+ * SPDX-License-Identifier: MIT
+ *
+ * Copyright (c) 2022 Chuck Wolber
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cassert>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "../Algorithm.hpp"
+#include "../order/ResultWriter.hpp"
+#include "TempFile.hpp"
+
+void test_text_round_trip();
+void test_can_number();
+
+void verify_turns(std::vector<Turn> results, std::vector<Turn> expected);
+
+int main() {
+    test_text_round_trip();
+    test_can_number();
+
+    return 0;
+}
+
+void test_text_round_trip() {
+    std::cout << "Testing text round trip... ";
+
+    /* Inner slices, wide turns, and one long enough for CONTINUATION records. */
+    std::vector<std::string> algorithms = {"2R Rw' F 3Bw 3U' D",
+                                           "R U' 2L' Lw",
+                                           "3Fw' 2D 2D' Uw Bw' 3R 2L F' B U D' R L' 2F 3U Dw' 2B' R"};
+
+    TempFile file;
+    int fd = open(file.getPath().c_str(), O_WRONLY);
+    assert(fd >= 0);
+    {
+        ResultWriter writer(1, fd, 0);
+        for (size_t i = 0; i < algorithms.size(); i++)
+            writer.pushResult(0, 0, i, Algorithm(algorithms[i].c_str()).getAlgorithm(),
+                              (unsigned int)(i + 2));
+    }
+    close(fd);
+
+    std::ifstream in(file.getPath());
+    std::string line;
+    size_t i = 0;
+    while (std::getline(in, line)) {
+        size_t ag = line.find("AG:");
+        assert(ag != std::string::npos);
+        std::string parsed = line.substr(ag + 3);
+        assert(Algorithm::isValid(parsed.c_str()));
+        verify_turns(Algorithm(parsed.c_str()).getAlgorithm(),
+                     Algorithm(algorithms.at(i).c_str()).getAlgorithm());
+        i++;
+    }
+    assert(i == algorithms.size());
+
+    std::cout << "Passed" << std::endl;
+}
+
+void test_can_number() {
+    std::cout << "Testing numbering in the output format... ";
+
+    std::cout << " t1 ";
+    {
+        ResultWriter text(1, -1, 0);
+        assert(text.canNumber(Algorithm("R U")));
+        assert(text.canNumber(Algorithm("2R Uw")));
+    }
+
+    /* Input algorithms carry numbers in their own layer depth. */
+    std::cout << " t2 ";
+    {
+        ResultWriter binary(1, -1, 0, ResultWriter::BINARY, Algorithm());
+        assert(binary.canNumber(Algorithm("R U")));
+        assert(!binary.canNumber(Algorithm("2R Uw")));
+        assert(!binary.canNumber(Algorithm("R Uw")));
+    }
+
+    std::cout << " t3 ";
+    {
+        ResultWriter binary(1, -1, 0, ResultWriter::BINARY, Algorithm("2R U"));
+        assert(binary.canNumber(Algorithm("2R Uw")));
+        assert(!binary.canNumber(Algorithm("R U")));
+    }
+
+    std::cout << "Passed" << std::endl;
+}
+
+void verify_turns(std::vector<Turn> results, std::vector<Turn> expected) {
+    assert(results.size() == expected.size());
+    for (unsigned int i = 0; i < expected.size(); i++) {
+        assert(expected.at(i).layer     == results.at(i).layer);
+        assert(expected.at(i).clockwise == results.at(i).clockwise);
+        assert(expected.at(i).depth     == results.at(i).depth);
+        assert(expected.at(i).wide      == results.at(i).wide);
+    }
+}